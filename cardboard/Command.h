@@ -24,6 +24,7 @@ struct Server;
  */
 struct CommandResult {
     std::string message;
+    bool success = true; ///< False if the command failed, \a message says why.
 };
 
 /**
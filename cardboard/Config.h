@@ -35,6 +35,13 @@ struct Config {
     struct {
         float r, g, b, a;
     } focus_color { 0.f, 0.f, 0.7f, 0.5f };
+
+    /**
+     * \brief Milliseconds to wait for the next key of a chord before cancelling it; default is 1000.
+     *
+     * Zero disables the timeout.
+     */
+    int chord_timeout = 1000;
 };
 
 #endif // CARDBOARD_CONFIG_H_INCLUDED
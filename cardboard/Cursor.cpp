@@ -16,6 +16,14 @@ extern "C" {
 #include <wlr/util/log.h>
 }
 
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <utility>
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+
 #include "Cursor.h"
 #include "Server.h"
 
@@ -45,14 +53,142 @@ static void register_image_surface(Server& server, SeatCursor& cursor, struct wl
     }
 }
 
-void init_cursor(OutputManager& output_manager, SeatCursor& cursor)
+/// Hands a theme loaded in background over to the xcursor manager, which frees it when destroyed.
+static void install_theme(SeatCursor& cursor, float scale, struct wlr_xcursor_theme* theme)
+{
+    if (!theme) {
+        wlr_log(WLR_ERROR, "Cannot load xcursor theme for scale %.2f", scale);
+        return;
+    }
+
+    // allocated the same way as in wlr_xcursor_manager_load
+    auto* scaled_theme = static_cast<struct wlr_xcursor_manager_theme*>(calloc(1, sizeof(struct wlr_xcursor_manager_theme)));
+    if (!scaled_theme) {
+        wlr_xcursor_theme_destroy(theme);
+        return;
+    }
+    scaled_theme->scale = scale;
+    scaled_theme->theme = theme;
+    wl_list_insert(&cursor.wlr_xcursor_manager->scaled_themes, &scaled_theme->link);
+}
+
+/// Installs the themes whose loading has finished, then sets the cursor image again to use them.
+static int theme_load_handler(int fd, uint32_t, void* data)
+{
+    auto* server = static_cast<Server*>(data);
+    auto& cursor = server->seat.cursor;
+
+    uint64_t count;
+    [[maybe_unused]] ssize_t _ = read(fd, &count, sizeof(count));
+
+    bool installed = false;
+    for (auto it = cursor.theme_loads.begin(); it != cursor.theme_loads.end();) {
+        if (it->result.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            ++it;
+            continue;
+        }
+        install_theme(cursor, it->scale, it->result.get().theme);
+        // the thread only has to write to the eventfd after publishing the result
+        it->thread.join();
+        it = cursor.theme_loads.erase(it);
+        installed = true;
+    }
+
+    if (installed) {
+        cursor_refresh_image(*server, server->seat, cursor);
+    }
+    return 0;
+}
+
+void init_cursor(Server& server, SeatCursor& cursor)
 {
     cursor.wlr_cursor = wlr_cursor_create();
     cursor.wlr_cursor->data = &cursor;
-    wlr_cursor_attach_output_layout(cursor.wlr_cursor, output_manager.output_layout);
+    wlr_cursor_attach_output_layout(cursor.wlr_cursor, server.output_manager->output_layout);
 
     cursor.wlr_xcursor_manager = wlr_xcursor_manager_create(nullptr, 24);
-    wlr_xcursor_manager_load(cursor.wlr_xcursor_manager, 1);
+
+    cursor.theme_load_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (cursor.theme_load_fd < 0) {
+        wlr_log_errno(WLR_ERROR, "Cannot create eventfd, xcursor themes will be loaded synchronously");
+    } else {
+        cursor.theme_load_source = wl_event_loop_add_fd(server.event_loop, cursor.theme_load_fd, WL_EVENT_READABLE, theme_load_handler, &server);
+    }
+
+    cursor_load_theme(cursor, 1);
+}
+
+void cursor_load_theme(SeatCursor& cursor, float scale)
+{
+    if (std::find(cursor.theme_scales.begin(), cursor.theme_scales.end(), scale) != cursor.theme_scales.end()) {
+        return;
+    }
+    cursor.theme_scales.push_back(scale);
+
+    // the name is owned by the xcursor manager, which outlives the loads
+    const char* name = cursor.wlr_xcursor_manager->name;
+    int size = static_cast<int>(cursor.wlr_xcursor_manager->size * scale);
+
+    if (!cursor.theme_load_source) {
+        install_theme(cursor, scale, wlr_xcursor_theme_load(name, size));
+        return;
+    }
+
+    std::promise<SeatCursor::LoadedTheme> promise;
+    auto result = promise.get_future();
+    std::thread thread { [name, size, fd = cursor.theme_load_fd, promise = std::move(promise)]() mutable {
+        int64_t start = monotonic_ns();
+        auto* theme = wlr_xcursor_theme_load(name, size);
+        int64_t end = monotonic_ns();
+
+        // publish the result before waking up the event loop, theme_load_handler only looks at ready results
+        promise.set_value({ theme, start, end });
+        uint64_t one = 1;
+        [[maybe_unused]] ssize_t _ = write(fd, &one, sizeof(one));
+    } };
+    cursor.theme_loads.push_back({ scale, std::move(result), std::move(thread) });
+}
+
+void cursor_finish_theme_load(Server& server, SeatCursor& cursor)
+{
+    for (auto& load : cursor.theme_loads) {
+        auto loaded = load.result.get();
+        load.thread.join();
+        server.startup_trace.add("xcursor_theme_load", loaded.start_ns, loaded.end_ns);
+        install_theme(cursor, load.scale, loaded.theme);
+    }
+    cursor.theme_loads.clear();
+}
+
+void cursor_stop_theme_loads(SeatCursor& cursor)
+{
+    for (auto& load : cursor.theme_loads) {
+        install_theme(cursor, load.scale, load.result.get().theme);
+        load.thread.join();
+    }
+    cursor.theme_loads.clear();
+
+    if (cursor.theme_load_source) {
+        wl_event_source_remove(cursor.theme_load_source);
+        cursor.theme_load_source = nullptr;
+    }
+    if (cursor.theme_load_fd != -1) {
+        close(cursor.theme_load_fd);
+        cursor.theme_load_fd = -1;
+    }
+}
+
+void cursor_refresh_image(Server&, Seat& seat, SeatCursor& cursor)
+{
+    if (!(seat.wlr_seat->capabilities & WL_SEAT_CAPABILITY_POINTER)) {
+        return;
+    }
+
+    if (!cursor.image.empty()) {
+        wlr_xcursor_manager_set_cursor_image(cursor.wlr_xcursor_manager, cursor.image.c_str(), cursor.wlr_cursor);
+    } else if (cursor.image_surface) {
+        wlr_cursor_set_surface(cursor.wlr_cursor, cursor.image_surface, cursor.image_hotspot_x, cursor.image_hotspot_y);
+    }
 }
 
 void cursor_set_image(Server& server, Seat& seat, SeatCursor& cursor, const char* image)
@@ -61,10 +197,19 @@ void cursor_set_image(Server& server, Seat& seat, SeatCursor& cursor, const char
         return;
     }
 
+    // moving over empty space sets the same image on every motion
+    bool already_shown = image ? cursor.image == image : (cursor.image.empty() && !cursor.image_surface);
+    if (already_shown) {
+        return;
+    }
+
     register_image_surface(server, cursor, nullptr);
+    cursor.image_surface = nullptr;
     if (!image) {
+        cursor.image.clear();
         wlr_cursor_set_image(cursor.wlr_cursor, nullptr, 0, 0, 0, 0, 0, 0);
     } else {
+        cursor.image = image;
         wlr_xcursor_manager_set_cursor_image(cursor.wlr_xcursor_manager, image, cursor.wlr_cursor);
     }
 }
@@ -75,8 +220,16 @@ void cursor_set_image_surface(Server& server, Seat& seat, SeatCursor& cursor, st
         return;
     }
 
+    if (cursor.image.empty() && cursor.image_surface == surface && cursor.image_hotspot_x == hotspot_x && cursor.image_hotspot_y == hotspot_y) {
+        return;
+    }
+
     register_image_surface(server, cursor, surface);
     wlr_cursor_set_surface(cursor.wlr_cursor, surface, hotspot_x, hotspot_y);
+    cursor.image.clear();
+    cursor.image_surface = surface;
+    cursor.image_hotspot_x = hotspot_x;
+    cursor.image_hotspot_y = hotspot_y;
 }
 
 void cursor_rebase(Server& server, Seat& seat, SeatCursor& cursor, uint32_t time)
@@ -18,6 +18,10 @@ extern "C" {
 }
 
 #include <cstdint>
+#include <future>
+#include <string>
+#include <thread>
+#include <vector>
 
 #include "OptionalRef.h"
 #include "OutputManager.h"
@@ -31,17 +35,70 @@ struct SeatCursor {
     struct wlr_xcursor_manager* wlr_xcursor_manager;
     OptionalRef<struct wl_listener> image_surface_destroy_listener;
 
+    /// Name of the xcursor image being shown, empty if the image is a client surface or if the cursor is hidden.
+    std::string image;
+    /// Client surface being shown as the cursor image, and its hotspot.
+    struct wlr_surface* image_surface = nullptr;
+    int32_t image_hotspot_x = 0;
+    int32_t image_hotspot_y = 0;
+
+    /// An xcursor theme loaded in background, with the start and end times of the load.
+    struct LoadedTheme {
+        /// nullptr if the theme couldn't be loaded
+        struct wlr_xcursor_theme* theme;
+        int64_t start_ns;
+        int64_t end_ns;
+    };
+    /// An xcursor theme being loaded in background for an output scale.
+    struct ThemeLoad {
+        float scale;
+        /// Ready before \c theme_load_fd is written.
+        std::future<LoadedTheme> result;
+        std::thread thread;
+    };
+    std::vector<ThemeLoad> theme_loads;
+    /// Scales for which a theme has been loaded or is being loaded.
+    std::vector<float> theme_scales;
+    /// Written by the loader threads when a theme is ready, to wake up the event loop.
+    int theme_load_fd = -1;
+    struct wl_event_source* theme_load_source = nullptr;
+
 private:
     /// Called when the surface of the mouse pointer is destroyed by the client.
     static void image_surface_destroy_handler(struct wl_listener* listener, void* data);
 };
 
-void init_cursor(OutputManager&, SeatCursor& cursor);
+/**
+ * \brief Creates the cursor and starts loading the xcursor theme for scale 1 in background.
+ *
+ * The theme is read from disk while the backend starts. Nothing can use the xcursor manager until
+ * cursor_finish_theme_load is called.
+ */
+void init_cursor(Server& server, SeatCursor& cursor);
+
+/**
+ * \brief Starts loading the xcursor theme for \a scale in background, if it isn't loaded already.
+ *
+ * The theme is added to the xcursor manager from the event loop when it is ready, and the cursor image
+ * is set again so that outputs with this scale show it.
+ */
+void cursor_load_theme(SeatCursor& cursor, float scale);
+
+/// Waits for the xcursor themes being loaded, before the event loop starts.
+void cursor_finish_theme_load(Server& server, SeatCursor& cursor);
+
+/// Waits for the xcursor themes being loaded and stops watching for them. Called when the server stops.
+void cursor_stop_theme_loads(SeatCursor& cursor);
+
+/// Sets the current cursor image again, for outputs that don't show it yet.
+void cursor_refresh_image(Server& server, Seat& seat, SeatCursor& cursor);
 
 /**
   * \brief Sets the cursor image to an xcursor named \a image.
   *
-  * \param image - xcursor image name
+  * Does nothing if \a image is already shown.
+  *
+  * \param image - xcursor image name, nullptr to hide the cursor
   */
 void cursor_set_image(Server& server, Seat& seat, SeatCursor& cursor, const char* image);
 /**
@@ -50,6 +107,7 @@ void cursor_set_image(Server& server, Seat& seat, SeatCursor& cursor, const char
   * The hotspot is the point of the cursor that interacts with the elements on the screen.
   * For a normal pointer, the hotspot is usually the tip of the cursor image.
   * For a cross pointer, the hotspot is usually in the center.
+  * Does nothing if \a surface is already shown with the same hotspot.
   */
 void cursor_set_image_surface(Server& server, Seat& seat, SeatCursor& cursor, struct wlr_surface* surface, int32_t hotspot_x, int32_t hotspot_y);
 /**
@@ -13,13 +13,15 @@ extern "C" {
 }
 
 #include <fcntl.h>
-#include <sys/ioctl.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <cerrno>
 #include <cstdint>
 #include <cstring>
+#include <variant>
 
 #include "IPC.h"
 #include "Server.h"
@@ -102,16 +104,13 @@ int IPC::handle_client_connection(int /*fd*/, uint32_t mask, void* data)
     }
 
     if ((flags = fcntl(client_fd, F_GETFL)) == -1
-        || fcntl(client_fd, F_GETFL, flags | O_NONBLOCK) == -1) {
+        || fcntl(client_fd, F_SETFL, flags | O_NONBLOCK) == -1) {
         wlr_log(WLR_ERROR, "Unable to set O_NONBLOCK on IPC client socket: %s", strerror(errno));
         close(client_fd);
         return 0;
     }
 
-    ipc->clients.emplace_back(
-        ipc,
-        client_fd,
-        IPC::ClientState::READING_HEADER);
+    ipc->clients.emplace_back(ipc, client_fd);
 
     ipc->clients.back().readable_event_source = wl_event_loop_add_fd(
         ipc->server->event_loop,
@@ -139,85 +138,144 @@ int IPC::handle_client_readable(int /*fd*/, uint32_t mask, void* data)
         return 0;
     }
 
-    int available_bytes;
-    if (ioctl(client->client_fd, FIONREAD, &available_bytes) == -1) {
-        wlr_log(WLR_INFO, "Unable to read pending available data");
-        client->ipc->remove_client(client);
-        return 0;
-    }
-
-    switch (client->state) {
-    case IPC::ClientState::READING_HEADER: {
-        if (available_bytes < static_cast<int>(libcardboard::ipc::HEADER_SIZE)) {
+    // read what the client pipelined, up to MAX_READ_PER_DISPATCH bytes. The rest is left in the socket
+    // for the next iteration of the event loop. The requests are executed after each read,
+    // so the buffer doesn't have to hold more than one incomplete request.
+    for (std::size_t read_total = 0; read_total < MAX_READ_PER_DISPATCH;) {
+        if (client->output_bytes > MAX_OUTPUT_BYTES) {
+            // the client doesn't read its responses, don't take new requests until it does
             break;
         }
 
-        libcardboard::ipc::AlignedHeaderBuffer buffer;
-        if (ssize_t received = recv(
-                client->client_fd,
-                buffer.data(),
-                libcardboard::ipc::HEADER_SIZE,
-                0);
-            received != -1) {
-            libcardboard::ipc::Header header = libcardboard::ipc::interpret_header(buffer);
-            client->payload_size = header.incoming_bytes;
-            client->state = IPC::ClientState::READING_PAYLOAD;
-
-            available_bytes -= received;
-
-            if (client->payload_size <= available_bytes) {
-                // do nothing jumps to the IPC::ClientState::READING_PAYLOAD case
-            } else {
+        std::byte spill[INPUT_SPILL_SIZE];
+        struct iovec iov[2] = {
+            { client->input.data() + client->input_end, client->input.size() - client->input_end },
+            { spill, sizeof(spill) },
+        };
+
+        ssize_t received = readv(client->client_fd, iov, 2);
+        if (received == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
                 break;
             }
-        } else {
-            wlr_log(WLR_INFO, "recv failed on header");
+
+            wlr_log(WLR_INFO, "recv failed on IPC client: %s", strerror(errno));
             client->ipc->remove_client(client);
             return 0;
         }
-        [[fallthrough]];
-    }
-    case IPC::ClientState::READING_PAYLOAD: {
-        if (client->payload_size > available_bytes)
-            break;
-
-        auto* buffer = new std::byte[client->payload_size];
-        if (ssize_t received = recv(
-                client->client_fd,
-                buffer,
-                client->payload_size,
-                0);
-            received == -1) {
-            wlr_log(WLR_INFO, "couldn't read payload");
+        if (received == 0) {
+            wlr_log(WLR_DEBUG, "IPC Client on fd %d closed the connection", client->client_fd);
             client->ipc->remove_client(client);
             return 0;
         }
-        read_command_data(buffer, client->payload_size)
-            .map([client](const CommandData& command_data) {
-                client->message = client->ipc->command_callback(command_data);
-            })
-            .map_error([client](const std::string& error) {
-                using namespace std::string_literals;
-                wlr_log(WLR_INFO, "unable to parse command: %s", error.c_str());
-                client->message = "Unable to parse command: " + error;
-            });
-        delete[] buffer;
-
-        client->writable_event_source = wl_event_loop_add_fd(
-            client->ipc->server->event_loop,
-            client->client_fd,
+
+        read_total += received;
+        auto in_buffer = std::min(static_cast<std::size_t>(received), iov[0].iov_len);
+        client->input_end += in_buffer;
+        if (static_cast<std::size_t>(received) > in_buffer) {
+            // the buffer is full, grow it with what didn't fit
+            client->input.insert(client->input.end(), spill, spill + (received - in_buffer));
+            client->input_end = client->input.size();
+        }
+
+        if (!client->ipc->process_requests(*client)) {
+            return 0;
+        }
+    }
+
+    // most responses fit in the socket buffer, don't wait for the next iteration to send them
+    if (!client->ipc->flush_output(*client)) {
+        return 0;
+    }
+    client->ipc->watch_writable(*client);
+    update_reading(*client);
+
+    return 0;
+}
+
+void IPC::update_reading(IPC::Client& client)
+{
+    bool pause = client.output_bytes > MAX_OUTPUT_BYTES;
+    if (pause == client.reading_paused) {
+        return;
+    }
+
+    // errors and hangups are still reported while the mask is empty
+    wl_event_source_fd_update(client.readable_event_source, pause ? 0 : WL_EVENT_READABLE);
+    client.reading_paused = pause;
+}
+
+void IPC::watch_writable(IPC::Client& client)
+{
+    if (!client.output.empty() && client.writable_event_source == nullptr) {
+        client.writable_event_source = wl_event_loop_add_fd(
+            server->event_loop,
+            client.client_fd,
             WL_EVENT_WRITABLE,
             IPC::handle_client_writeable,
-            client);
+            &client);
+    }
+}
+
+bool IPC::process_requests(IPC::Client& client)
+{
+    // the requests left in the buffer are executed after the client reads enough of its responses
+    while (client.output_bytes <= MAX_OUTPUT_BYTES && client.input_end - client.input_begin >= libcardboard::ipc::HEADER_SIZE) {
+        const std::byte* frame = client.input.data() + client.input_begin;
+
+        libcardboard::ipc::AlignedHeaderBuffer header_buffer;
+        memcpy(header_buffer.data(), frame, libcardboard::ipc::HEADER_SIZE);
+        libcardboard::ipc::Header header = libcardboard::ipc::interpret_header(header_buffer);
+
+        if (header.incoming_bytes < 0 || static_cast<std::size_t>(header.incoming_bytes) > libcardboard::ipc::MAX_PAYLOAD_SIZE) {
+            wlr_log(WLR_INFO, "IPC Client on fd %d sent a malformed header, disconnecting", client.client_fd);
+            remove_client(&client);
+            return false;
+        }
+
+        std::size_t payload_size = header.incoming_bytes;
+        if (client.input_end - client.input_begin - libcardboard::ipc::HEADER_SIZE < payload_size) {
+            // wait for the rest of the payload
+            break;
+        }
+
+        std::string message;
+        // decoded in place, straight from the receive buffer
+        if (auto command_data = read_command_data(frame + libcardboard::ipc::HEADER_SIZE, payload_size); !command_data) {
+            wlr_log(WLR_INFO, "unable to parse command: %s", command_data.error().c_str());
+            message = "Unable to parse command: " + command_data.error();
+        } else if (auto* subscribe = std::get_if<command_arguments::subscribe>(&*command_data)) {
+            // the subscription belongs to the connection, not to the compositor state
+            client.subscribed_events = subscribe->events & libcardboard::events::ALL_TYPES;
+            client.json_events = subscribe->json;
+        } else {
+            message = command_callback(*command_data);
+        }
+        client.input_begin += libcardboard::ipc::HEADER_SIZE + payload_size;
 
-        client->state = IPC::ClientState::WRITING;
-        break;
+        auto response_header = libcardboard::ipc::create_header_buffer({ static_cast<int>(message.size()), header.request_id });
+        client.output_bytes += response_header.size() + message.size();
+        client.output.push_back({ response_header, std::move(message) });
     }
-    case IPC::ClientState::WRITING:
-        break; // do nothing
+
+    if (client.input_begin == client.input_end) {
+        client.input_begin = client.input_end = 0;
+        if (client.input.size() > INPUT_BUFFER_SIZE) {
+            // don't keep the memory of an unusually large request around
+            client.input.resize(INPUT_BUFFER_SIZE);
+            client.input.shrink_to_fit();
+        }
+    } else if (client.input_begin > 0) {
+        // move the incomplete request to the front, making room for the rest of it
+        std::memmove(client.input.data(), client.input.data() + client.input_begin, client.input_end - client.input_begin);
+        client.input_end -= client.input_begin;
+        client.input_begin = 0;
     }
 
-    return 0;
+    return true;
 }
 
 int IPC::handle_client_writeable(int /*fd*/, uint32_t mask, void* data)
@@ -236,32 +294,185 @@ int IPC::handle_client_writeable(int /*fd*/, uint32_t mask, void* data)
         return 0;
     }
 
-    if (!client->message.empty()) {
-        libcardboard::ipc::AlignedHeaderBuffer header = libcardboard::ipc::create_header_buffer({ static_cast<int>(client->message.size()) });
+    if (!client->ipc->flush_output(*client)) {
+        return 0;
+    }
+    if (client->reading_paused && client->output_bytes <= MAX_OUTPUT_BYTES) {
+        // execute the requests that were held back, then go back to reading
+        if (!client->ipc->process_requests(*client) || !client->ipc->flush_output(*client)) {
+            return 0;
+        }
+        update_reading(*client);
+    }
+    if (!client->output.empty()) {
+        // resume when the socket is writable again
+        return 0;
+    }
 
-        auto* buffer = new std::byte[client->message.empty() + header.size()];
-        std::copy(
-            header.begin(),
-            header.end(),
-            buffer);
+    // everything was sent, keep the connection for the next requests
+    wl_event_source_remove(client->writable_event_source);
+    client->writable_event_source = nullptr;
 
-        std::copy(
-            client->message.begin(),
-            client->message.end(),
-            reinterpret_cast<char*>(buffer));
+    return 0;
+}
 
-        ssize_t written = write(client->client_fd, buffer, client->message.empty() + header.size());
-        if (written == -1 && errno == EAGAIN) {
-            return 0;
+bool IPC::flush_output(IPC::Client& client)
+{
+    while (!client.output.empty()) {
+        struct iovec iov[MAX_WRITE_IOVECS];
+        int iov_count = 0;
+
+        std::size_t skip = client.output_offset;
+        for (auto it = client.output.begin(); it != client.output.end() && iov_count + 2 <= MAX_WRITE_IOVECS; ++it) {
+            if (skip < it->header.size()) {
+                iov[iov_count++] = { it->header.data() + skip, it->header.size() - skip };
+                skip = 0;
+            } else {
+                skip -= it->header.size();
+            }
+            if (it->body.size() > skip) {
+                iov[iov_count++] = { it->body.data() + skip, it->body.size() - skip };
+            }
+            skip = 0;
         }
 
+        ssize_t written = writev(client.client_fd, iov, iov_count);
         if (written == -1) {
-            wlr_log(WLR_INFO, "Unable to send data to IPC client");
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return true;
+            }
+
+            wlr_log(WLR_INFO, "Unable to send data to IPC client: %s", strerror(errno));
+            remove_client(&client);
+            return false;
+        }
+
+        // drop the messages that were sent completely, remember where the partially sent one stopped
+        auto remaining = static_cast<std::size_t>(written);
+        while (remaining > 0) {
+            auto& message = client.output.front();
+            std::size_t message_left = message.header.size() + message.body.size() - client.output_offset;
+            if (remaining < message_left) {
+                client.output_offset += remaining;
+                break;
+            }
+
+            remaining -= message_left;
+            client.output_bytes -= message.header.size() + message.body.size();
+            client.output.pop_front();
+            client.output_offset = 0;
+        }
+
+        if (client.output.empty()) {
+            // continue with the events that were held back while the output was being sent
+            queue_events(client);
         }
     }
 
-    client->ipc->remove_client(client);
-    return 0;
+    return true;
+}
+
+void IPC::publish(libcardboard::events::Event event)
+{
+    using libcardboard::events::Type;
+
+    bool has_subscribers = std::any_of(clients.begin(), clients.end(), [&event](const auto& client) {
+        return client.subscribed_events & libcardboard::events::type_mask(event.type);
+    });
+    if (!has_subscribers) {
+        return;
+    }
+
+    if (event.type == Type::ViewFocused || event.type == Type::WorkspaceFocused) {
+        // only the last focus change of the iteration matters
+        pending_events.erase(std::remove_if(pending_events.begin(), pending_events.end(), [&event](const auto& pending) {
+                                 return pending.type == event.type;
+                             }),
+                             pending_events.end());
+    } else if (std::find(pending_events.begin(), pending_events.end(), event) != pending_events.end()) {
+        return;
+    }
+    pending_events.push_back(std::move(event));
+
+    if (flush_event_source == nullptr) {
+        flush_event_source = wl_event_loop_add_idle(server->event_loop, IPC::handle_flush_events, this);
+    }
+}
+
+void IPC::handle_flush_events(void* data)
+{
+    auto ipc = static_cast<IPC*>(data);
+    // idle sources are destroyed after being dispatched
+    ipc->flush_event_source = nullptr;
+
+    auto events = std::move(ipc->pending_events);
+    ipc->pending_events.clear();
+
+    for (const auto& event : events) {
+        // encode lazily, at most once per format
+        std::optional<std::string> binary, json;
+
+        for (auto& client : ipc->clients) {
+            if (!(client.subscribed_events & libcardboard::events::type_mask(event.type))) {
+                continue;
+            }
+
+            auto& encoded = client.json_events ? json : binary;
+            if (!encoded) {
+                encoded = client.json_events ? libcardboard::events::encode_json(event) : libcardboard::events::encode_binary(event);
+            }
+
+            if (client.events.size() == MAX_QUEUED_EVENTS) {
+                client.events.pop_front();
+                if (client.dropped_events++ == 0) {
+                    wlr_log(WLR_DEBUG, "IPC Client on fd %d is too slow, dropping events", client.client_fd);
+                }
+            }
+            client.events.push_back(*encoded);
+        }
+    }
+
+    for (auto it = ipc->clients.begin(); it != ipc->clients.end();) {
+        // flush_output can remove the client
+        auto& client = *it++;
+        if (!client.events.empty()) {
+            queue_events(client);
+            if (ipc->flush_output(client)) {
+                ipc->watch_writable(client);
+            }
+        }
+    }
+}
+
+void IPC::queue_events(IPC::Client& client)
+{
+    if (!client.output.empty()) {
+        return;
+    }
+
+    for (auto& event : client.events) {
+        auto header = libcardboard::ipc::create_header_buffer({ static_cast<int>(event.size()), 0 });
+        client.output_bytes += header.size() + event.size();
+        client.output.push_back({ header, std::move(event) });
+    }
+    client.events.clear();
+}
+
+IPC::~IPC()
+{
+    if (flush_event_source) {
+        wl_event_source_remove(flush_event_source);
+    }
+}
+
+void publish_event(Server& server, libcardboard::events::Event event)
+{
+    if (server.ipc) {
+        server.ipc->publish(std::move(event));
+    }
 }
 
 void IPC::remove_client(IPC::Client* client)
@@ -273,7 +484,10 @@ void IPC::remove_client(IPC::Client* client)
 IPC::Client::~Client()
 {
     // shutdown routine for ipc client
-    shutdown(client_fd, SHUT_RDWR);
+    if (client_fd != -1) {
+        shutdown(client_fd, SHUT_RDWR);
+        close(client_fd);
+    }
 
     if (readable_event_source) {
         wl_event_source_remove(readable_event_source);
@@ -287,15 +501,24 @@ IPC::Client::~Client()
 IPC::Client::Client(IPC::Client&& other) noexcept
     : ipc { other.ipc }
     , client_fd { other.client_fd }
-    , state { other.state }
     , readable_event_source { other.readable_event_source }
     , writable_event_source { other.writable_event_source }
-    , payload_size { other.payload_size }
-    , message { std::move(other.message) }
+    , input { std::move(other.input) }
+    , input_begin { other.input_begin }
+    , input_end { other.input_end }
+    , output { std::move(other.output) }
+    , output_offset { other.output_offset }
+    , output_bytes { other.output_bytes }
+    , reading_paused { other.reading_paused }
+    , subscribed_events { other.subscribed_events }
+    , json_events { other.json_events }
+    , events { std::move(other.events) }
+    , dropped_events { other.dropped_events }
 {
     other.ipc = nullptr;
-    other.client_fd = 0;
+    other.client_fd = -1;
     other.readable_event_source = nullptr;
     other.writable_event_source = nullptr;
-    other.payload_size = 0;
+    other.output_offset = 0;
+    other.output_bytes = 0;
 }
@@ -12,12 +12,16 @@ You should have received a copy of the GNU General Public License along with thi
 #define CARDBOARD_IPC_H_INCLUDED
 
 #include <cstdint>
+#include <deque>
 #include <optional>
 #include <string>
 #include <vector>
 
 #include <sys/un.h>
 
+#include <cardboard/event_protocol.h>
+#include <cardboard/ipc.h>
+
 #include "Listener.h"
 #include "NotNull.h"
 
@@ -38,15 +42,33 @@ using IPCInstance = std::unique_ptr<IPC>;
 
 /**
  * \brief Manages all incoming client connections, communicating with them using the Cardboard IPC protocol
+ *
+ * Connections are persistent: a client can send many requests, without waiting for the responses
+ * of the previous ones. The requests are executed and answered in the order they arrive.
+ *
+ * A client that sends the \c subscribe command also receives the events it subscribed to, see libcardboard::events.
+ * The events published during an event loop iteration are coalesced and sent when the loop becomes idle.
  */
 class IPC {
+    /// Initial size of the receive buffer of a client. It is enough for almost every request.
+    static constexpr std::size_t INPUT_BUFFER_SIZE = 4096;
+    /// Size of the stack buffer that takes the bytes that don't fit in the receive buffer of a client.
+    static constexpr std::size_t INPUT_SPILL_SIZE = 16384;
+    /// Maximum number of bytes read from a client in one dispatch, so that a busy client can't starve the event loop.
+    static constexpr std::size_t MAX_READ_PER_DISPATCH = 65536;
+    /// Number of queued output bytes above which a client's requests aren't read until it reads its responses.
+    static constexpr std::size_t MAX_OUTPUT_BYTES = 1 << 20;
+    /// Maximum number of buffers given to a single \c writev call.
+    static constexpr int MAX_WRITE_IOVECS = 64;
+
     /**
-     * \brief describes the stage of the client-server protocol communication of a client
+     * \brief a response or an event waiting to be sent
+     *
+     * The header and the body are sent with one \c writev call, the body is not copied.
      */
-    enum class ClientState {
-        READING_HEADER,
-        READING_PAYLOAD,
-        WRITING
+    struct OutgoingMessage {
+        libcardboard::ipc::AlignedHeaderBuffer header;
+        std::string body;
     };
 
     /**
@@ -55,16 +77,37 @@ class IPC {
     struct Client {
         IPC* ipc;
         int client_fd;
-        ClientState state;
         wl_event_source* readable_event_source = nullptr;
         wl_event_source* writable_event_source = nullptr;
-        int payload_size = 0;
-        std::string message {};
-
-        Client(IPC* ipc, int client_fd, ClientState state)
+        /**
+         * \brief Receive buffer, reused for all the requests of the client
+         *
+         * The bytes in <tt>[input_begin, input_end)</tt> were received but don't form a complete request yet.
+         * The rest of the buffer is free space for the next read.
+         */
+        std::vector<std::byte> input = std::vector<std::byte>(INPUT_BUFFER_SIZE);
+        std::size_t input_begin = 0;
+        std::size_t input_end = 0;
+        /// Responses that haven't been written yet, oldest first.
+        std::deque<OutgoingMessage> output {};
+        /// Number of bytes of the first message in \c output that were already written.
+        std::size_t output_offset = 0;
+        /// Total size of the messages in \c output, including the part of the first one that was already written.
+        std::size_t output_bytes = 0;
+        /// True while the client isn't read from because \c output_bytes is over IPC::MAX_OUTPUT_BYTES.
+        bool reading_paused = false;
+
+        /// Mask of the events the client subscribed to, 0 if it didn't subscribe.
+        uint32_t subscribed_events = 0;
+        bool json_events = false;
+        /// Encoded events waiting for \c output to be drained, at most IPC::MAX_QUEUED_EVENTS.
+        std::deque<std::string> events {};
+        /// Number of events dropped because the client was too slow.
+        std::size_t dropped_events = 0;
+
+        Client(IPC* ipc, int client_fd)
             : ipc(ipc)
             , client_fd(client_fd)
-            , state(state)
         {
         }
         Client(const Client&) = delete;
@@ -94,6 +137,17 @@ public:
     IPC() = delete;
     IPC(const IPC&) = delete;
     IPC(IPC&&) = default;
+    ~IPC();
+
+    /// Maximum number of events queued for a client. When full, the oldest event is dropped.
+    static constexpr std::size_t MAX_QUEUED_EVENTS = 256;
+
+    /**
+     * \brief Queues \a event to be sent to the subscribed clients at the end of the current event loop iteration
+     *
+     * Focus events replace the pending focus event of the same type, and duplicate events are ignored.
+     */
+    void publish(libcardboard::events::Event event);
 
 private:
     /**
@@ -111,6 +165,40 @@ private:
      */
     static int handle_client_writeable(int fd, uint32_t mask, void* data);
 
+    /**
+     * \brief executes all the complete requests in the input buffer of \a client and queues their responses
+     *
+     * \return false if the client sent garbage and has been disconnected
+     */
+    bool process_requests(Client& client);
+
+    /**
+     * \brief the callback wayland calls when the event loop is idle, sends the published events to the clients
+     */
+    static void handle_flush_events(void* data);
+
+    /**
+     * \brief moves the queued events of \a client to its output queue, if the previous output was sent
+     */
+    static void queue_events(Client& client);
+
+    /**
+     * \brief writes as much of the output queue of \a client as the socket accepts without blocking
+     *
+     * \return false if the client has been disconnected because of a write error
+     */
+    bool flush_output(Client& client);
+
+    /**
+     * \brief starts listening for the writability of the \a client socket if there is output left to send
+     */
+    void watch_writable(Client& client);
+
+    /**
+     * \brief stops reading from \a client while its queued output is over MAX_OUTPUT_BYTES, resumes reading otherwise
+     */
+    static void update_reading(Client& client);
+
 private:
     /**
      * \brief removes a client from the clients list - thus disconnecting it as well
@@ -126,6 +214,10 @@ private:
 
     std::list<Client> clients;
 
+    /// Events published during the current event loop iteration.
+    std::vector<libcardboard::events::Event> pending_events;
+    wl_event_source* flush_event_source = nullptr;
+
     friend std::optional<IPCInstance> create_ipc(Server& server, const std::string& socket_path, std::function<std::string(const CommandData&)> command_callback);
 };
 
@@ -138,4 +230,11 @@ private:
  */
 std::optional<IPCInstance> create_ipc(Server& server, const std::string& socket_path, std::function<std::string(const CommandData&)> command_callback);
 
+/**
+ * \brief Publishes \a event to the IPC clients of \a server
+ *
+ * Does nothing if the IPC system is not initialized yet.
+ */
+void publish_event(Server& server, libcardboard::events::Event event);
+
 #endif // CARDBOARD_IPC_H_INCLUDED
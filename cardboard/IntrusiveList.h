@@ -0,0 +1,227 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+Copyright (C) 2020 Alexandru-Iulian Magan, Tudor-Ioan Roman, and contributors.
+
+This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 3.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef CARDBOARD_INTRUSIVE_LIST_H_INCLUDED
+#define CARDBOARD_INTRUSIVE_LIST_H_INCLUDED
+
+#include <cassert>
+#include <cstddef>
+#include <iterator>
+
+/**
+ * \brief The links an object needs to be part of an IntrusiveList.
+ *
+ * Embed one hook for every list the object can be part of at the same time.
+ */
+template <typename T>
+struct IntrusiveListHook {
+    T* prev = nullptr;
+    T* next = nullptr;
+};
+
+/// Finds the hook of an element that is a data member of the element, see IntrusiveList.
+template <typename T, IntrusiveListHook<T> T::*member>
+struct MemberHook {
+    static IntrusiveListHook<T>& get(T& element) { return element.*member; }
+    static const IntrusiveListHook<T>& get(const T& element) { return element.*member; }
+};
+
+/**
+ * \brief A doubly linked list whose links live inside the elements themselves.
+ *
+ * The list doesn't own its elements and never allocates. Insertion and removal are O(1)
+ * because an element knows its neighbours. An element must be removed from the list before it is destroyed.
+ *
+ * \a Hook has static \c get functions returning the hook of an element. Usually it is a MemberHook,
+ * but a hand-written one lets the list be declared where \a T is still incomplete.
+ *
+ * \code{.cpp}
+ * struct Foo {
+ *     IntrusiveListHook<Foo> link;
+ * };
+ * IntrusiveList<Foo, MemberHook<Foo, &Foo::link>> foos;
+ * \endcode
+ */
+template <typename T, typename Hook>
+class IntrusiveList {
+public:
+    template <bool reverse>
+    struct BasicIterator {
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = T*;
+        using reference = T&;
+
+        T* node;
+
+        T& operator*() const { return *node; }
+        T* operator->() const { return node; }
+
+        BasicIterator& operator++()
+        {
+            node = reverse ? Hook::get(*node).prev : Hook::get(*node).next;
+            return *this;
+        }
+
+        BasicIterator operator++(int)
+        {
+            auto old = *this;
+            ++*this;
+            return old;
+        }
+
+        bool operator==(const BasicIterator& other) const { return node == other.node; }
+        bool operator!=(const BasicIterator& other) const { return node != other.node; }
+    };
+    using Iterator = BasicIterator<false>;
+    using ReverseIterator = BasicIterator<true>;
+
+    /// Range adaptor for iterating the list from back to front.
+    struct ReverseRange {
+        T* tail;
+
+        ReverseIterator begin() const { return { tail }; }
+        ReverseIterator end() const { return { nullptr }; }
+    };
+
+    IntrusiveList() = default;
+    IntrusiveList(const IntrusiveList&) = delete;
+    IntrusiveList& operator=(const IntrusiveList&) = delete;
+
+    /// The elements link to each other, not to the list, so they can be handed over as they are.
+    IntrusiveList(IntrusiveList&& other) noexcept
+        : head { other.head }
+        , tail { other.tail }
+        , count { other.count }
+    {
+        other.head = other.tail = nullptr;
+        other.count = 0;
+    }
+
+    IntrusiveList& operator=(IntrusiveList&& other) noexcept
+    {
+        assert(empty());
+        head = other.head;
+        tail = other.tail;
+        count = other.count;
+        other.head = other.tail = nullptr;
+        other.count = 0;
+        return *this;
+    }
+
+    Iterator begin() const { return { head }; }
+    Iterator end() const { return { nullptr }; }
+    ReverseRange reversed() const { return { tail }; }
+
+    bool empty() const { return head == nullptr; }
+    std::size_t size() const { return count; }
+
+    T& front() const
+    {
+        assert(head != nullptr);
+        return *head;
+    }
+
+    T& back() const
+    {
+        assert(tail != nullptr);
+        return *tail;
+    }
+
+    /// Returns true if \a element is linked in this list.
+    bool contains(const T& element) const
+    {
+        return Hook::get(element).prev != nullptr || head == &element;
+    }
+
+    void push_front(T& element)
+    {
+        assert(!contains(element));
+        auto& links = Hook::get(element);
+        links.prev = nullptr;
+        links.next = head;
+        if (head) {
+            Hook::get(*head).prev = &element;
+        } else {
+            tail = &element;
+        }
+        head = &element;
+        count++;
+    }
+
+    void push_back(T& element)
+    {
+        assert(!contains(element));
+        auto& links = Hook::get(element);
+        links.next = nullptr;
+        links.prev = tail;
+        if (tail) {
+            Hook::get(*tail).next = &element;
+        } else {
+            head = &element;
+        }
+        tail = &element;
+        count++;
+    }
+
+    /// Unlinks \a element. It must be part of this list.
+    void remove(T& element)
+    {
+        assert(contains(element));
+        auto& links = Hook::get(element);
+        if (links.prev) {
+            Hook::get(*links.prev).next = links.next;
+        } else {
+            head = links.next;
+        }
+        if (links.next) {
+            Hook::get(*links.next).prev = links.prev;
+        } else {
+            tail = links.prev;
+        }
+        links.prev = links.next = nullptr;
+        count--;
+    }
+
+    /// Links \a element right after \a position, which must be part of this list.
+    void insert_after(T& position, T& element)
+    {
+        assert(contains(position) && !contains(element));
+        auto& position_links = Hook::get(position);
+        auto& links = Hook::get(element);
+        links.prev = &position;
+        links.next = position_links.next;
+        if (position_links.next) {
+            Hook::get(*position_links.next).prev = &element;
+        } else {
+            tail = &element;
+        }
+        position_links.next = &element;
+        count++;
+    }
+
+    /// Moves \a element, which must be part of this list, to the front of the list.
+    void move_to_front(T& element)
+    {
+        if (head == &element) {
+            return;
+        }
+        remove(element);
+        push_front(element);
+    }
+
+private:
+    T* head = nullptr;
+    T* tail = nullptr;
+    std::size_t count = 0;
+};
+
+#endif // CARDBOARD_INTRUSIVE_LIST_H_INCLUDED
@@ -15,56 +15,223 @@ extern "C" {
 #include <wlr/types/wlr_input_device.h>
 }
 
+#include <algorithm>
+#include <cassert>
+
 #include "Helpers.h"
 #include "Keyboard.h"
 #include "Server.h"
 
+KeybindingsConfig::KeybindingsConfig()
+{
+    mode_root = chord_node = add_node();
+    modes.emplace(DEFAULT_MODE, mode_root);
+}
+
+bool KeybindingsConfig::bind(const std::string& mode, const std::vector<KeyCombo>& sequence, Command command)
+{
+    if (sequence.empty()) {
+        return true;
+    }
+
+    uint32_t node = NO_NODE;
+    if (auto it = modes.find(mode); it != modes.end()) {
+        node = it->second;
+    }
+
+    // walk the part of the sequence that is already in the trie
+    auto combo_it = sequence.begin();
+    for (; node != NO_NODE && combo_it != sequence.end(); combo_it++) {
+        uint32_t child = find_child(node, *combo_it);
+        if (child == NO_NODE) {
+            break;
+        }
+        if (node_commands[child] != NO_COMMAND) {
+            // a prefix of the sequence (or the whole sequence) is already bound
+            return true;
+        }
+        node = child;
+    }
+    if (combo_it == sequence.end()) {
+        // the sequence is the beginning of a bound chord
+        return true;
+    }
+
+    // node ids must fit in the bits make_key reserves for them
+    std::size_t new_nodes = (node == NO_NODE ? 1 : 0) + static_cast<std::size_t>(sequence.end() - combo_it);
+    if (node_commands.size() + new_nodes > MAX_NODES) {
+        return false;
+    }
+
+    if (node == NO_NODE) {
+        node = add_node();
+        modes.emplace(mode, node);
+    }
+
+    for (; combo_it != sequence.end(); combo_it++) {
+        uint32_t child = add_node();
+        edge_keys.push_back(make_key(node, *combo_it));
+        edge_targets.push_back(child);
+        node = child;
+    }
+
+    node_commands[node] = commands.size();
+    commands.push_back(std::move(command));
+    rebuild();
+    return true;
+}
+
+bool KeybindingsConfig::set_mode(const std::string& mode)
+{
+    auto it = modes.find(mode);
+    if (it == modes.end()) {
+        return false;
+    }
+
+    mode_root = chord_node = it->second;
+    return true;
+}
+
+KeybindingsConfig::Match KeybindingsConfig::press(KeyCombo combo, OptionalRef<const Command>& command)
+{
+    uint32_t child = find_child(chord_node, combo);
+    if (child == NO_NODE) {
+        reset_chord();
+        return Match::None;
+    }
+
+    if (uint32_t command_index = node_commands[child]; command_index != NO_COMMAND) {
+        reset_chord();
+        command = OptionalRef<const Command>(commands[command_index]);
+        return Match::Complete;
+    }
+
+    chord_node = child;
+    return Match::Partial;
+}
+
+int KeybindingsConfig::chord_timeout_handler(void* data)
+{
+    auto* config = static_cast<KeybindingsConfig*>(data);
+    config->reset_chord();
+
+    return 0;
+}
+
+uint32_t KeybindingsConfig::find_child(uint32_t node, KeyCombo combo) const
+{
+    if (table.empty()) {
+        return NO_NODE;
+    }
+
+    uint64_t key = make_key(node, combo);
+    std::size_t mask = table.size() - 1;
+    for (std::size_t i = hash(key, shift);; i = (i + 1) & mask) {
+        const Slot& slot = table[i];
+        if (slot.node == NO_NODE || slot.key == key) {
+            return slot.node;
+        }
+    }
+}
+
+uint32_t KeybindingsConfig::add_node()
+{
+    assert(node_commands.size() < MAX_NODES && "too many key bindings");
+
+    node_commands.push_back(NO_COMMAND);
+    return node_commands.size() - 1;
+}
+
+void KeybindingsConfig::rebuild()
+{
+    unsigned bits = 1;
+    while ((std::size_t { 1 } << bits) < edge_keys.size() * 2) {
+        bits++;
+    }
+    shift = 64 - bits;
+
+    table.assign(std::size_t { 1 } << bits, Slot { 0, NO_NODE });
+    std::size_t mask = table.size() - 1;
+    for (std::size_t edge = 0; edge < edge_keys.size(); edge++) {
+        std::size_t i = hash(edge_keys[edge], shift);
+        while (table[i].node != NO_NODE) {
+            i = (i + 1) & mask;
+        }
+        table[i] = { edge_keys[edge], edge_targets[edge] };
+    }
+}
+
+/// Returns true if \a keysym is a modifier key, which doesn't advance or cancel chords.
+static bool is_modifier_keysym(xkb_keysym_t keysym)
+{
+    return (keysym >= XKB_KEY_Shift_L && keysym <= XKB_KEY_Hyper_R)
+        || (keysym >= XKB_KEY_ISO_Lock && keysym <= XKB_KEY_ISO_Level5_Lock)
+        || keysym == XKB_KEY_Mode_switch || keysym == XKB_KEY_Num_Lock;
+}
+
 void KeyboardHandleData::destroy_handler(struct wl_listener* listener, void*)
 {
     auto* server = get_server(listener);
-    auto handle_data = get_listener_data<KeyboardHandleData>(listener);
+    auto* handle_data = get_listener_data<KeyboardHandleData*>(listener);
 
     server->listeners.clear_listeners(handle_data);
 
-    handle_data.seat->keyboards.erase(std::remove_if(handle_data.seat->keyboards.begin(), handle_data.seat->keyboards.end(), [&handle_data](const auto& other) {
-                                          return handle_data.keyboard == &other;
-                                      }),
-                                      handle_data.seat->keyboards.end());
+    // the handle data lives inside the keyboard, copy what's needed before erasing it.
+    // list::remove_if unlinks the node in place, so the listeners of the other keyboards,
+    // which are keyed by the address of their handle data, stay valid
+    Seat* seat = handle_data->seat;
+    Keyboard* keyboard = handle_data->keyboard;
+    seat->keyboards.remove_if([keyboard](const auto& other) {
+        return keyboard == &other;
+    });
 }
 
-void KeyboardHandleData::modifiers_handler(struct wl_listener* listener, void*)
+void KeyboardHandleData::modifiers_handler(Server&, void*)
 {
-    auto handle_data = get_listener_data<KeyboardHandleData>(listener);
-
-    wlr_seat_set_keyboard(handle_data.seat->wlr_seat, handle_data.keyboard->device);
+    wlr_seat_set_keyboard(seat->wlr_seat, keyboard->device);
     // send modifiers to the client
-    wlr_seat_keyboard_notify_modifiers(handle_data.seat->wlr_seat, &handle_data.keyboard->device->keyboard->modifiers);
+    wlr_seat_keyboard_notify_modifiers(seat->wlr_seat, &keyboard->device->keyboard->modifiers);
 }
 
-void KeyboardHandleData::key_handler(struct wl_listener* listener, void* data)
+void KeyboardHandleData::key_handler(Server& server, void* data)
 {
-    Server* server = get_server(listener);
-    auto handle_data = get_listener_data<KeyboardHandleData>(listener);
-
     auto* event = static_cast<struct wlr_event_keyboard_key*>(data);
 
     bool handled = false;
-    uint32_t modifiers = wlr_keyboard_get_modifiers(handle_data.keyboard->device->keyboard);
+    uint32_t modifiers = wlr_keyboard_get_modifiers(keyboard->device->keyboard);
     if (event->state == WLR_KEY_PRESSED) {
         const xkb_keysym_t* syms;
         int syms_number = xkb_state_key_get_syms(
-            handle_data.keyboard->device->keyboard->xkb_state,
+            keyboard->device->keyboard->xkb_state,
             event->keycode + 8,
             &syms);
 
         // TODO: keybinds that work when there is an exclusive client
-        if (!handle_data.seat->exclusive_client) {
+        if (!seat->exclusive_client) {
             for (int i = 0; i < syms_number; i++) {
-                auto& map = handle_data.config->map[modifiers];
                 // as you can see below, keysyms are always stored lowercase
-                if (auto it = map.find(xkb_keysym_to_lower(syms[i])); it != map.end()) {
-                    (it->second)(server);
+                KeyCombo combo = { modifiers, xkb_keysym_to_lower(syms[i]) };
+                if (config->in_chord() && is_modifier_keysym(combo.keysym)) {
+                    continue;
+                }
+
+                bool was_in_chord = config->in_chord();
+                OptionalRef<const Command> command;
+                switch (config->press(combo, command)) {
+                case KeybindingsConfig::Match::Complete:
+                    wl_event_source_timer_update(config->chord_timer, 0);
+                    command.unwrap()(&server);
+                    handled = true;
+                    break;
+                case KeybindingsConfig::Match::Partial:
+                    wl_event_source_timer_update(config->chord_timer, server.config.chord_timeout);
                     handled = true;
+                    break;
+                case KeybindingsConfig::Match::None:
+                    // the key that breaks a chord is swallowed too
+                    wl_event_source_timer_update(config->chord_timer, 0);
+                    handled = handled || was_in_chord;
+                    break;
                 }
             }
         }
@@ -74,8 +241,8 @@ void KeyboardHandleData::key_handler(struct wl_listener* listener, void* data)
         if (!handled) {
             for (int i = 0; i < syms_number; i++) {
                 if (syms[i] >= XKB_KEY_XF86Switch_VT_1 && syms[i] <= XKB_KEY_XF86Switch_VT_12) {
-                    if (wlr_backend_is_multi(server->backend)) {
-                        if (auto* session = wlr_backend_get_session(server->backend); session) {
+                    if (wlr_backend_is_multi(server.backend)) {
+                        if (auto* session = wlr_backend_get_session(server.backend); session) {
                             auto vt = syms[i] - XKB_KEY_XF86Switch_VT_1 + 1;
                             wlr_session_change_vt(session, vt);
                         }
@@ -87,18 +254,19 @@ void KeyboardHandleData::key_handler(struct wl_listener* listener, void* data)
     }
 
     if (!handled) {
-        wlr_seat_set_keyboard(handle_data.seat->wlr_seat, handle_data.keyboard->device);
-        wlr_seat_keyboard_notify_key(handle_data.seat->wlr_seat, event->time_msec, event->keycode, event->state);
+        wlr_seat_set_keyboard(seat->wlr_seat, keyboard->device);
+        wlr_seat_keyboard_notify_key(seat->wlr_seat, event->time_msec, event->keycode, event->state);
     }
 }
 
 void register_keyboard_handlers(Server& server, Seat& seat, Keyboard& keyboard)
 {
+    keyboard.handle_data = KeyboardHandleData { &seat, &keyboard, &server.keybindings_config };
     register_handlers(server,
-                      KeyboardHandleData { &seat, &keyboard, &server.keybindings_config },
+                      &*keyboard.handle_data,
                       {
-                          { &keyboard.device->keyboard->events.key, KeyboardHandleData::key_handler },
-                          { &keyboard.device->keyboard->events.modifiers, KeyboardHandleData::modifiers_handler },
+                          { &keyboard.device->keyboard->events.key, TypedListener<KeyboardHandleData, &KeyboardHandleData::key_handler>::notify },
+                          { &keyboard.device->keyboard->events.modifiers, TypedListener<KeyboardHandleData, &KeyboardHandleData::modifiers_handler>::notify },
                           { &keyboard.device->keyboard->events.destroy, KeyboardHandleData::destroy_handler },
                       });
 }
@@ -16,10 +16,17 @@ extern "C" {
 #include <wlr/types/wlr_input_device.h>
 }
 
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <string>
+#include <string_view>
 #include <unordered_map>
+#include <vector>
 
 #include "Command.h"
 #include "NotNull.h"
+#include "OptionalRef.h"
 
 /**
  * \file
@@ -29,10 +36,40 @@ extern "C" {
 
 struct Server;
 struct Seat;
+struct Keyboard;
+struct KeybindingsConfig;
+
+/**
+ * \brief Object that is passed to keyboard-related handlers for context.
+ */
+struct KeyboardHandleData {
+    NotNullPointer<Seat> seat; ///< The seat of the device
+    NotNullPointer<Keyboard> keyboard; ///< The device from which the key handling event arised
+    NotNullPointer<KeybindingsConfig> config; ///< Pointer to the global key binding configuration
+
+private:
+    /**
+      * \brief Fired when a non-modifier key is pressed.
+      *
+      * Executes key binding commands if the key together with the currently active
+      * modifiers match. Else, sends the key to the surface currently holding keyboard focus.
+      */
+    void key_handler(Server& server, void* data);
+
+    /// Signals that a keyboard has been disconnected.
+    static void destroy_handler(struct wl_listener* listener, void* data);
+
+    /// Notifies the currently focused surface about the pressed state of the modifier keys.
+    void modifiers_handler(Server& server, void* data);
+
+    friend void register_keyboard_handlers(Server& server, Seat& seat, Keyboard& keyboard);
+};
 
 /// A keyboard device, managed by a seat.
 struct Keyboard {
     struct wlr_input_device* device;
+    /// Context of the event handlers of this keyboard, set by register_keyboard_handlers.
+    std::optional<KeyboardHandleData> handle_data;
 
 private:
     // i can't make a friend only the required method (Seat::add_keyboard) because
@@ -40,6 +77,12 @@ private:
     friend struct Seat;
 };
 
+/// A key pressed together with some modifiers.
+struct KeyCombo {
+    uint32_t modifiers;
+    xkb_keysym_t keysym; ///< Always the lowercase variant.
+};
+
 /**
  * \brief This structure holds the configured key bindings.
  *
@@ -57,59 +100,113 @@ private:
  * \code{.sh}
  * cutter exec terminal
  * \endcode
+ *
+ * A key binding can also be a chord, a sequence of key combinations pressed one after another,
+ * and can belong to a mode other than the default one. Only the bindings of the current mode are active:
+ *
+ * \code{.sh}
+ * cutter bind super+w,3 workspace switch 3
+ * cutter bind super+r mode resize
+ * cutter bind --mode resize h resize -50 0
+ * cutter bind --mode resize escape mode default
+ * \endcode
+ *
+ * The bindings of all the modes are compiled into a trie. Each mode has its own root and
+ * each edge is a key combination. The edges are kept in a single open addressing table keyed on
+ * <tt>(node, modifiers, keysym)</tt>, so advancing through the trie on a key press is one hash lookup.
  */
 struct KeybindingsConfig {
     static_assert(WLR_MODIFIER_COUNT <= 12, "too many modifiers");
 
+    /// The mode that is active at startup. Key bindings that don't specify a mode belong to it.
+    static constexpr std::string_view DEFAULT_MODE = "default";
+
+    /// The outcome of pressing a key combination, see KeybindingsConfig::press.
+    enum class Match {
+        None, ///< The key combination isn't bound, any chord in progress was cancelled.
+        Partial, ///< The key combination continues a chord, more keys are expected.
+        Complete, ///< The key combination completed a binding.
+    };
+
+    KeybindingsConfig();
+
     /**
-     * \brief An array of key binding maps, for each modifier combination.
-     *
-     * The array index is the mod mask of the key binding.
+     * \brief Binds \a command to the key combinations of \a sequence, pressed one after another, in \a mode.
      *
-     * They key of each map is the lowercase variant of the keysym, and the value is
-     * a pair of an IPC command handler and its arguments.
+     * The mode is created if it doesn't exist. Does nothing if the sequence or one of its prefixes is already bound,
+     * or if the sequence is the prefix of a bound chord.
      *
-     * \attention The \c keysym \b must be the lowercase variant! Key bindings containing uppercase characters
+     * \attention The keysyms \b must be the lowercase variant! Key bindings containing uppercase characters
      * will have the shift mod mask set.
      *
-     * For example, to retrieve the IPC command for the <tt>super + shift + x</tt> binding:
+     * \returns \c false, binding nothing, if there is no room left in the trie for the sequence.
+     */
+    bool bind(const std::string& mode, const std::vector<KeyCombo>& sequence, Command command);
+
+    /// Activates the bindings of \a mode and cancels any chord in progress. Returns false if there is no such mode.
+    bool set_mode(const std::string& mode);
+
+    /**
+     * \brief Advances the current chord with \a combo.
      *
-     * \code{.cpp}
-     * map[WLR_MODIFIER_LOGO | WLR_MODIFIER_SHIFT][XKB_KEY_x] // notice the lowercase `x`
-     * \endcode
+     * If a binding is completed, \a command is set to its command.
      */
-    std::unordered_map<xkb_keysym_t, Command> map[(1 << WLR_MODIFIER_COUNT) - 1];
-};
+    Match press(KeyCombo combo, OptionalRef<const Command>& command);
 
-/**
- * \brief Object that is passed to keyboard-related handlers for context.
- */
-struct KeyboardHandleData {
-    NotNullPointer<Seat> seat; ///< The seat of the device
-    NotNullPointer<Keyboard> keyboard; ///< The device from which the key handling event arised
-    NotNullPointer<KeybindingsConfig> config; ///< Pointer to the global key binding configuration
+    /// Returns true if some keys of a chord have been pressed.
+    bool in_chord() const { return chord_node != mode_root; }
 
-    bool operator==(KeyboardHandleData other) const
-    {
-        return keyboard == other.keyboard && config == other.config;
-    }
+    /// Forgets the keys pressed so far in the current chord.
+    void reset_chord() { chord_node = mode_root; }
+
+    /// Cancels the chord in progress when the user stops typing.
+    static int chord_timeout_handler(void* data);
+
+    /// Timer that fires after Config::chord_timeout milliseconds without a key press during a chord.
+    struct wl_event_source* chord_timer = nullptr;
 
 private:
-    /**
-      * \brief Fired when a non-modifier key is pressed.
-      *
-      * Executes key binding commands if the key together with the currently active
-      * modifiers match. Else, sends the key to the surface currently holding keyboard focus.
-      */
-    static void key_handler(struct wl_listener* listener, void* data);
+    static constexpr uint32_t NO_NODE = UINT32_MAX;
+    static constexpr uint32_t NO_COMMAND = UINT32_MAX;
+    static constexpr uint32_t MAX_NODES = 1 << 20;
 
-    /// Signals that a keyboard has been disconnected.
-    static void destroy_handler(struct wl_listener* listener, void* data);
+    /// A slot of the open addressing table. Empty slots have \c node set to \c NO_NODE.
+    struct Slot {
+        uint64_t key;
+        uint32_t node;
+    };
 
-    /// Notifies the currently focused surface about the pressed state of the modifier keys.
-    static void modifiers_handler(struct wl_listener* listener, void* data);
+    static constexpr uint64_t make_key(uint32_t node, KeyCombo combo)
+    {
+        return (static_cast<uint64_t>(node) << 44) | (static_cast<uint64_t>(combo.modifiers & 0xfff) << 32) | combo.keysym;
+    }
 
-    friend void register_keyboard_handlers(Server& server, Seat& seat, Keyboard& keyboard);
+    /// Fibonacci hashing of \a key into a table of <tt>2^(64 - shift)</tt> slots.
+    static constexpr std::size_t hash(uint64_t key, unsigned shift)
+    {
+        return static_cast<std::size_t>((key * 0x9e3779b97f4a7c15ull) >> shift);
+    }
+
+    /// Returns the child of \a node reached by pressing \a combo, or \c NO_NODE.
+    uint32_t find_child(uint32_t node, KeyCombo combo) const;
+    uint32_t add_node();
+    /// Rebuilds the lookup table from the edges of the trie, keeping it at most half full.
+    void rebuild();
+
+    /// For each node of the trie, the index of its command in \c commands or \c NO_COMMAND.
+    std::vector<uint32_t> node_commands;
+    /// The edges of the trie, as table keys. Reaching \c edge_targets[i] means pressing \c edge_keys[i].
+    std::vector<uint64_t> edge_keys;
+    std::vector<uint32_t> edge_targets;
+    /// Commands of the bindings. A deque, so that a running command stays valid if it binds new keys.
+    std::deque<Command> commands;
+    std::vector<Slot> table;
+    unsigned shift = 64;
+
+    /// The root node of each mode.
+    std::unordered_map<std::string, uint32_t> modes;
+    uint32_t mode_root;
+    uint32_t chord_node;
 };
 
 void register_keyboard_handlers(Server& server, Seat& seat, Keyboard& keyboard);
@@ -0,0 +1,289 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+Copyright (C) 2020 Alexandru-Iulian Magan, Tudor-Ioan Roman, and contributors.
+
+This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 3.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+extern "C" {
+#include <wlr/util/log.h>
+}
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "Launcher.h"
+#include "Spawn.h"
+
+/*
+ * Requests are single SOCK_SEQPACKET messages: the argument count and the environment size as
+ * native uint32_t values, followed by the arguments and then the environment variables, each NUL-terminated.
+ * Replies are an int error code followed by the program name.
+ */
+
+/// Decodes a request into \a argv and \a env. Returns false if it is malformed.
+static bool decode_request(const char* data, std::size_t size, std::vector<std::string>& argv, std::vector<std::string>& env)
+{
+    uint32_t counts[2];
+    if (size < sizeof(counts)) {
+        return false;
+    }
+    std::memcpy(counts, data, sizeof(counts));
+
+    const char* it = data + sizeof(counts);
+    const char* end = data + size;
+    for (uint32_t i = 0; i < counts[0] + counts[1]; i++) {
+        const char* nul = static_cast<const char*>(std::memchr(it, '\0', end - it));
+        if (nul == nullptr) {
+            return false;
+        }
+        (i < counts[0] ? argv : env).emplace_back(it, nul);
+        it = nul + 1;
+    }
+
+    return !argv.empty();
+}
+
+/// Closes every file descriptor except the standard streams and \a keep_fd. Only async-signal-safe calls, it runs right after fork.
+static void close_other_fds(int keep_fd)
+{
+#ifdef SYS_close_range
+    // keep_fd is never one of the standard streams
+    bool closed_below = keep_fd == 3 || syscall(SYS_close_range, 3u, static_cast<unsigned>(keep_fd - 1), 0u) == 0;
+    if (closed_below && syscall(SYS_close_range, static_cast<unsigned>(keep_fd + 1), ~0u, 0u) == 0) {
+        return;
+    }
+#endif
+    long max_fd = sysconf(_SC_OPEN_MAX);
+    for (int fd = 3; fd < max_fd; fd++) {
+        if (fd != keep_fd) {
+            close(fd);
+        }
+    }
+}
+
+void Launcher::run_helper(int socket_fd)
+{
+    // the signal handlers of the compositor don't make sense here, and the children are reaped automatically
+    signal(SIGINT, SIG_DFL);
+    signal(SIGHUP, SIG_DFL);
+    signal(SIGTERM, SIG_DFL);
+    signal(SIGCHLD, SIG_IGN);
+
+    std::vector<char> buffer(Launcher::MAX_REQUEST_SIZE);
+    while (true) {
+        ssize_t size = recv(socket_fd, buffer.data(), buffer.size(), 0);
+        if (size == -1 && errno == EINTR) {
+            continue;
+        }
+        if (size <= 0) {
+            // the compositor is gone
+            _exit(EXIT_SUCCESS);
+        }
+
+        std::vector<std::string> argv, env;
+        int error = EINVAL;
+        if (decode_request(buffer.data(), size, argv, env)) {
+            clearenv();
+            for (auto& variable : env) {
+                putenv(variable.data());
+            }
+            error = spawn(argv).value();
+        }
+
+        std::string reply(sizeof(error), '\0');
+        std::memcpy(reply.data(), &error, sizeof(error));
+        reply += argv.empty() ? "" : argv[0];
+        send(socket_fd, reply.data(), reply.size(), MSG_NOSIGNAL);
+        // the environment points into env, which is destroyed now
+        clearenv();
+    }
+}
+
+bool Launcher::start()
+{
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, fds) == -1) {
+        wlr_log(WLR_ERROR, "Couldn't create the launcher socket: %s", strerror(errno));
+        return false;
+    }
+    if (int flags = fcntl(fds[0], F_GETFL); flags == -1 || fcntl(fds[0], F_SETFL, flags | O_NONBLOCK) == -1) {
+        wlr_log(WLR_ERROR, "Couldn't make the launcher socket non-blocking: %s", strerror(errno));
+        close(fds[0]);
+        close(fds[1]);
+        return false;
+    }
+
+    // once the event loop runs, the compositor holds the GPU, the input devices and a lot of memory
+    bool reexec = event_loop != nullptr;
+    char fd_argument[16];
+    snprintf(fd_argument, sizeof(fd_argument), "%d", fds[1]);
+
+    pid = fork();
+    if (pid == -1) {
+        wlr_log(WLR_ERROR, "Couldn't fork the launcher: %s", strerror(errno));
+        close(fds[0]);
+        close(fds[1]);
+        return false;
+    }
+    if (pid == 0) {
+        close_other_fds(fds[1]);
+        if (!reexec) {
+            run_helper(fds[1]);
+        }
+
+        // the process may be multithreaded by now, only async-signal-safe calls until exec
+        int flags = fcntl(fds[1], F_GETFD);
+        if (flags != -1 && fcntl(fds[1], F_SETFD, flags & ~FD_CLOEXEC) != -1) {
+            execl("/proc/self/exe", "cardboard", LAUNCHER_HELPER_ARGUMENT, fd_argument, static_cast<char*>(nullptr));
+        }
+        _exit(EXIT_FAILURE);
+    }
+
+    close(fds[1]);
+    socket_fd = fds[0];
+    if (event_loop != nullptr) {
+        register_handlers(event_loop);
+    }
+
+    return true;
+}
+
+void Launcher::register_handlers(wl_event_loop* event_loop_)
+{
+    event_loop = event_loop_;
+    if (socket_fd != -1 && event_source == nullptr) {
+        event_source = wl_event_loop_add_fd(event_loop, socket_fd, WL_EVENT_READABLE, Launcher::handle_reply, this);
+    }
+}
+
+std::error_code Launcher::launch(const std::vector<std::string>& argv)
+{
+    if (argv.empty()) {
+        return std::error_code(EINVAL, std::generic_category());
+    }
+    if (socket_fd == -1 && !start()) {
+        return std::error_code(ECHILD, std::generic_category());
+    }
+
+    uint32_t counts[2] = { static_cast<uint32_t>(argv.size()), 0 };
+    std::string request(sizeof(counts), '\0');
+    for (const auto& arg : argv) {
+        request.append(arg.c_str(), arg.size() + 1);
+    }
+    for (char** variable = environ; *variable != nullptr; variable++) {
+        request.append(*variable, std::strlen(*variable) + 1);
+        counts[1]++;
+    }
+    std::memcpy(request.data(), counts, sizeof(counts));
+
+    if (request.size() > MAX_REQUEST_SIZE) {
+        return std::error_code(E2BIG, std::generic_category());
+    }
+
+    // the socket is non-blocking: if the helper is stuck, fail with EAGAIN instead of freezing the event loop
+    while (send(socket_fd, request.data(), request.size(), MSG_NOSIGNAL) == -1) {
+        if (errno != EINTR) {
+            return std::error_code(errno, std::generic_category());
+        }
+    }
+
+    return {};
+}
+
+void Launcher::stop(bool wait)
+{
+    if (event_source != nullptr) {
+        wl_event_source_remove(event_source);
+        event_source = nullptr;
+    }
+    if (socket_fd != -1) {
+        close(socket_fd);
+        socket_fd = -1;
+    }
+    if (pid > 0) {
+        exiting_pids.push_back(pid);
+        pid = -1;
+    }
+
+    if (wait) {
+        if (reap_timer != nullptr) {
+            wl_event_source_remove(reap_timer);
+            reap_timer = nullptr;
+        }
+        for (pid_t exiting_pid : exiting_pids) {
+            waitpid(exiting_pid, nullptr, 0);
+        }
+        exiting_pids.clear();
+        return;
+    }
+
+    reap_exited(this);
+}
+
+int Launcher::reap_exited(void* data)
+{
+    auto* launcher = static_cast<Launcher*>(data);
+
+    auto& pids = launcher->exiting_pids;
+    pids.erase(std::remove_if(pids.begin(), pids.end(), [](pid_t exiting_pid) {
+                   return waitpid(exiting_pid, nullptr, WNOHANG) != 0;
+               }),
+               pids.end());
+
+    if (pids.empty()) {
+        if (launcher->reap_timer != nullptr) {
+            wl_event_source_remove(launcher->reap_timer);
+            launcher->reap_timer = nullptr;
+        }
+        return 0;
+    }
+
+    if (launcher->reap_timer == nullptr && launcher->event_loop != nullptr) {
+        launcher->reap_timer = wl_event_loop_add_timer(launcher->event_loop, Launcher::reap_exited, launcher);
+    }
+    if (launcher->reap_timer != nullptr) {
+        wl_event_source_timer_update(launcher->reap_timer, REAP_INTERVAL_MS);
+    }
+    return 0;
+}
+
+int Launcher::handle_reply(int fd, uint32_t mask, void* data)
+{
+    auto* launcher = static_cast<Launcher*>(data);
+
+    char reply[sizeof(int) + 256];
+    ssize_t size = (mask & WL_EVENT_READABLE) ? recv(fd, reply, sizeof(reply) - 1, MSG_DONTWAIT) : 0;
+    if (size == -1 && (errno == EAGAIN || errno == EINTR)) {
+        return 0;
+    }
+    if (size < static_cast<ssize_t>(sizeof(int))) {
+        wlr_log(WLR_ERROR, "The launcher exited, it will be restarted on the next launch");
+        // the socket may close a moment before the helper exits, don't wait for it on the event loop
+        launcher->stop(false);
+        return 0;
+    }
+
+    int error;
+    std::memcpy(&error, reply, sizeof(error));
+    reply[size] = '\0';
+    if (error != 0) {
+        wlr_log(WLR_ERROR, "Couldn't execute %s: %s", reply + sizeof(error), strerror(error));
+    }
+
+    return 0;
+}
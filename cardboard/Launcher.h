@@ -0,0 +1,90 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+Copyright (C) 2020 Alexandru-Iulian Magan, Tudor-Ioan Roman, and contributors.
+
+This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 3.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef CARDBOARD_LAUNCHER_H_INCLUDED
+#define CARDBOARD_LAUNCHER_H_INCLUDED
+
+extern "C" {
+#include <wayland-server.h>
+}
+
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include <sys/types.h>
+
+/**
+ * \brief A small helper process that starts programs on behalf of the compositor
+ *
+ * The helper is forked at the very beginning of Server::init, before the backend loads the GPU drivers,
+ * so it stays tiny: starting a program from it doesn't depend on the memory size of the compositor.
+ * The compositor sends the argument vector and its current environment over a socket pair, and the helper
+ * starts the program with spawn(). The helper is the parent of every program started this way and reaps them.
+ *
+ * Exec failures are reported back and logged from the event loop of the compositor, without blocking it.
+ * If the helper dies, it is started again on the next launch. This time the compositor is already big,
+ * so the forked child re-executes the compositor binary in helper mode (see LAUNCHER_HELPER_ARGUMENT)
+ * instead of keeping a copy of its address space. In both cases the helper closes every file descriptor
+ * other than its socket and the standard streams.
+ *
+ * The compositor's end of the socket is non-blocking, a helper that doesn't keep up makes launches fail with \c EAGAIN.
+ */
+struct Launcher {
+    /// Maximum size of a launch request: the argument vector and the environment.
+    static constexpr std::size_t MAX_REQUEST_SIZE = 1 << 16;
+    /// Command line argument that makes the compositor binary run as the helper, followed by the socket's file descriptor.
+    static constexpr const char* LAUNCHER_HELPER_ARGUMENT = "--launcher-helper";
+
+    /// How often the helpers that were stopped without waiting are checked for, in milliseconds.
+    static constexpr int REAP_INTERVAL_MS = 100;
+
+    /// Compositor's end of the socket pair, -1 if the helper is not running.
+    int socket_fd = -1;
+    pid_t pid = -1;
+    wl_event_source* event_source = nullptr;
+    wl_event_loop* event_loop = nullptr;
+    /// Helpers that were stopped but haven't exited yet.
+    std::vector<pid_t> exiting_pids;
+    /// Timer that reaps #exiting_pids, armed while there are any.
+    wl_event_source* reap_timer = nullptr;
+
+    /// Forks the helper. Returns false if it couldn't be started.
+    bool start();
+
+    /// Runs the helper on \a socket_fd, in a process started with LAUNCHER_HELPER_ARGUMENT. Never returns.
+    [[noreturn]] static void run_helper(int socket_fd);
+
+    /// Watches the helper's replies on \a event_loop.
+    void register_handlers(wl_event_loop* event_loop);
+
+    /**
+     * \brief Asks the helper to start \a argv, with the current environment of the compositor
+     *
+     * \returns an error if the request couldn't be sent. Errors of \c exec are only logged, asynchronously.
+     */
+    std::error_code launch(const std::vector<std::string>& argv);
+
+    /**
+     * \brief Stops watching the helper and closes the socket. The helper exits when it sees the socket closed.
+     *
+     * With \a wait, blocks until the helper exited. Otherwise, the helper is reaped later from the event loop,
+     * which must not block on it.
+     */
+    void stop(bool wait = true);
+
+private:
+    /// Called when the helper reports the result of a launch, or when it dies.
+    static int handle_reply(int fd, uint32_t mask, void* data);
+    /// Reaps the #exiting_pids that exited, and checks again later for the others.
+    static int reap_exited(void* data);
+};
+
+#endif // CARDBOARD_LAUNCHER_H_INCLUDED
@@ -42,13 +42,14 @@ static void create_layer_popup(Server& server, NotNullPointer<struct wlr_xdg_pop
 void create_layer(Server& server, LayerSurface&& layer_surface_)
 {
     auto layer = layer_surface_.surface->client_pending.layer;
-    server.surface_manager.layers[layer].push_back(layer_surface_);
-    auto& layer_surface = server.surface_manager.layers[layer].back();
+    auto& layer_surfaces = layer_surface_.output.unwrap().layers[layer];
+    layer_surfaces.push_back(layer_surface_);
+    auto& layer_surface = layer_surfaces.back();
     layer_surface.layer = layer;
     layer_surface.surface->data = &layer_surface;
 
     register_handlers(server, &layer_surface, {
-                                                  { &layer_surface.surface->surface->events.commit, LayerSurface::commit_handler },
+                                                  { &layer_surface.surface->surface->events.commit, TypedListener<LayerSurface, &LayerSurface::commit_handler>::notify },
                                                   { &layer_surface.surface->events.destroy, LayerSurface::destroy_handler },
                                                   { &layer_surface.surface->events.map, LayerSurface::map_handler },
                                                   { &layer_surface.surface->events.unmap, LayerSurface::unmap_handler },
@@ -83,9 +84,20 @@ bool LayerSurface::get_surface_under_coords(double lx, double ly, struct wlr_sur
     return false;
 }
 
-bool LayerSurface::is_on_output(Output& out) const
+bool LayerSurface::needs_arrange() const
 {
-    return output && &output.unwrap() == &out;
+    const auto& current = surface->current;
+    return surface->mapped != arranged_mapped
+        || current.anchor != arranged_state.anchor
+        || current.exclusive_zone != arranged_state.exclusive_zone
+        || current.margin.top != arranged_state.margin.top
+        || current.margin.right != arranged_state.margin.right
+        || current.margin.bottom != arranged_state.margin.bottom
+        || current.margin.left != arranged_state.margin.left
+        || current.keyboard_interactive != arranged_state.keyboard_interactive
+        || current.desired_width != arranged_state.desired_width
+        || current.desired_height != arranged_state.desired_height
+        || current.layer != arranged_state.layer;
 }
 
 void LayerSurfacePopup::unconstrain(OutputManager& output_manager)
@@ -165,10 +177,6 @@ static void arrange_layer(Output& output, LayerArray::value_type& layer_surfaces
     wlr_output_effective_resolution(output.wlr_output, &full_area.width, &full_area.height);
 
     for (auto& layer_surface : layer_surfaces) {
-        if (!layer_surface.is_on_output(output)) {
-            continue;
-        }
-
         const auto* state = &layer_surface.surface->current;
         if (exclusive != (state->exclusive_zone > 0)) {
             continue;
@@ -229,14 +237,22 @@ static void arrange_layer(Output& output, LayerArray::value_type& layer_surfaces
             box.y -= state->margin.bottom;
         }
 
+        layer_surface.arranged_state = *state;
+        layer_surface.arranged_mapped = layer_surface.surface->mapped;
+
         if (box.width < 0 || box.height < 0) {
             wlr_layer_surface_v1_close(layer_surface.surface);
             continue;
         }
 
+        // the configure only carries the size
+        bool size_changed = box.width != layer_surface.geometry.width || box.height != layer_surface.geometry.height;
         layer_surface.geometry = box;
         apply_exclusive_zone(usable_area, state);
-        wlr_layer_surface_v1_configure(layer_surface.surface, box.width, box.height);
+        if (size_changed || !layer_surface.configured) {
+            wlr_layer_surface_v1_configure(layer_surface.surface, box.width, box.height);
+            layer_surface.configured = true;
+        }
     }
 }
 
@@ -246,28 +262,29 @@ void arrange_layers(Server& server, Output& output)
     wlr_output_effective_resolution(output.wlr_output, &usable_area.width, &usable_area.height);
 
     // arrange exclusive surfaces from top to bottom
-    arrange_layer(output, server.surface_manager.layers[ZWLR_LAYER_SHELL_V1_LAYER_OVERLAY], &usable_area, true);
-    arrange_layer(output, server.surface_manager.layers[ZWLR_LAYER_SHELL_V1_LAYER_TOP], &usable_area, true);
-    arrange_layer(output, server.surface_manager.layers[ZWLR_LAYER_SHELL_V1_LAYER_BOTTOM], &usable_area, true);
-    arrange_layer(output, server.surface_manager.layers[ZWLR_LAYER_SHELL_V1_LAYER_BACKGROUND], &usable_area, true);
+    arrange_layer(output, output.layers[ZWLR_LAYER_SHELL_V1_LAYER_OVERLAY], &usable_area, true);
+    arrange_layer(output, output.layers[ZWLR_LAYER_SHELL_V1_LAYER_TOP], &usable_area, true);
+    arrange_layer(output, output.layers[ZWLR_LAYER_SHELL_V1_LAYER_BOTTOM], &usable_area, true);
+    arrange_layer(output, output.layers[ZWLR_LAYER_SHELL_V1_LAYER_BACKGROUND], &usable_area, true);
 
     if (memcmp(&usable_area, &output.usable_area, sizeof(struct wlr_box)) != 0) {
         output.usable_area = usable_area;
-        auto ws_it = std::find_if(server.output_manager->workspaces.begin(), server.output_manager->workspaces.end(), [&output](const auto& other) { return other.output && other.output.raw_pointer() == &output; });
-        assert(ws_it != server.output_manager->workspaces.end());
+        server.output_manager->mark_outputs_changed();
+        assert(output.workspace);
+        auto& ws = output.workspace.unwrap();
         wlr_log(WLR_DEBUG, "usable area changed");
-        if (auto focused_view = server.seat.get_focused_view(); focused_view.has_value() && focused_view.unwrap().workspace_id == ws_it->index) {
-            ws_it->fit_view_on_screen(*(server.output_manager), focused_view.unwrap());
+        if (auto focused_view = server.seat.get_focused_view(); focused_view.has_value() && focused_view.unwrap().workspace_id == ws.index) {
+            ws.fit_view_on_screen(*(server.output_manager), focused_view.unwrap());
         } else {
-            ws_it->arrange_workspace(*(server.output_manager));
+            ws.arrange_workspace(*(server.output_manager));
         }
     }
 
     // arrange non-exclusive surfaces from top to bottom
-    arrange_layer(output, server.surface_manager.layers[ZWLR_LAYER_SHELL_V1_LAYER_OVERLAY], &usable_area, false);
-    arrange_layer(output, server.surface_manager.layers[ZWLR_LAYER_SHELL_V1_LAYER_TOP], &usable_area, false);
-    arrange_layer(output, server.surface_manager.layers[ZWLR_LAYER_SHELL_V1_LAYER_BOTTOM], &usable_area, false);
-    arrange_layer(output, server.surface_manager.layers[ZWLR_LAYER_SHELL_V1_LAYER_BACKGROUND], &usable_area, false);
+    arrange_layer(output, output.layers[ZWLR_LAYER_SHELL_V1_LAYER_OVERLAY], &usable_area, false);
+    arrange_layer(output, output.layers[ZWLR_LAYER_SHELL_V1_LAYER_TOP], &usable_area, false);
+    arrange_layer(output, output.layers[ZWLR_LAYER_SHELL_V1_LAYER_BOTTOM], &usable_area, false);
+    arrange_layer(output, output.layers[ZWLR_LAYER_SHELL_V1_LAYER_BACKGROUND], &usable_area, false);
 
     // finds top-most layer surface, if it exists
 
@@ -278,8 +295,8 @@ void arrange_layers(Server& server, Output& output)
     };
     LayerSurface* topmost = nullptr;
     for (const auto layer : layers_above_shell) {
-        for (auto& layer_surface : server.surface_manager.layers[layer]) {
-            if (layer_surface.surface->current.keyboard_interactive && layer_surface.is_on_output(output) && layer_surface.surface->mapped) {
+        for (auto& layer_surface : output.layers[layer]) {
+            if (layer_surface.surface->current.keyboard_interactive && layer_surface.surface->mapped) {
                 topmost = &layer_surface;
                 break;
             }
@@ -296,27 +313,27 @@ void arrange_layers(Server& server, Output& output)
     }
 }
 
-void LayerSurface::commit_handler(struct wl_listener* listener, void*)
+void LayerSurface::commit_handler(Server& server, void*)
 {
-    auto* server = get_server(listener);
-    auto* layer_surface = get_listener_data<LayerSurface*>(listener);
-
-    layer_surface->output.and_then([server](auto& output) {
-        arrange_layers(*server, output);
-    });
-
-    bool layer_changed = layer_surface->layer != layer_surface->surface->current.layer;
-    if (layer_changed) {
-        auto& old_layer = server->surface_manager.layers[layer_surface->layer];
-        auto& new_layer = server->surface_manager.layers[layer_surface->surface->current.layer];
+    bool layer_changed = layer != surface->current.layer;
+    if (layer_changed && output) {
+        auto& old_layer = output.unwrap().layers[layer];
+        auto& new_layer = output.unwrap().layers[surface->current.layer];
 
-        auto old_layer_it = std::find_if(old_layer.begin(), old_layer.end(), [layer_surface](const auto& other) { return &other == layer_surface; });
+        auto old_layer_it = std::find_if(old_layer.begin(), old_layer.end(), [this](const auto& other) { return &other == this; });
         if (old_layer_it != old_layer.end()) {
-            new_layer.splice(old_layer_it, old_layer, new_layer.end());
+            new_layer.splice(new_layer.end(), old_layer, old_layer_it);
         }
-        layer_surface->layer = layer_surface->surface->current.layer;
     }
-    server->output_manager->set_dirty();
+    layer = surface->current.layer;
+
+    // most commits only update the contents of the surface, like a clock on a bar
+    if (!configured || needs_arrange()) {
+        output.and_then([&server](auto& layer_output) {
+            arrange_layers(server, layer_output);
+        });
+    }
+    server.output_manager->set_dirty();
 }
 
 void LayerSurface::destroy_handler(struct wl_listener* listener, void*)
@@ -327,9 +344,11 @@ void LayerSurface::destroy_handler(struct wl_listener* listener, void*)
     wlr_log(WLR_DEBUG, "destroyed layer surface: namespace %s layer %d", layer_surface->surface->namespace_, layer_surface->surface->current.layer);
     server->listeners.clear_listeners(layer_surface);
 
-    server->surface_manager.layers[layer_surface->layer].remove_if([layer_surface](const auto& other) { return &other == layer_surface; });
     // we arrange in destroy and not in unmap because unmapping is always preceded by a commit event which should take care of it
-    layer_surface->output.and_then([server](auto& out) { arrange_layers(*server, out); });
+    auto output = layer_surface->output;
+    auto& layer_surfaces = output ? output.unwrap().layers[layer_surface->layer] : server->surface_manager.orphan_layers;
+    layer_surfaces.remove_if([layer_surface](const auto& other) { return &other == layer_surface; });
+    output.and_then([server](auto& out) { arrange_layers(*server, out); });
 }
 
 void LayerSurface::map_handler(struct wl_listener* listener, void*)
@@ -350,6 +369,12 @@ void LayerSurface::unmap_handler(struct wl_listener* listener, void*)
         server->seat.focus_layer(*server, nullptr);
     }
     //server->seat.cursor.rebase(server);
+
+    // a surface mapped again starts over, it must be configured again even if its size doesn't change.
+    // The commit that unmapped it arranges the layers and sends that configure
+    layer_surface->configured = false;
+    layer_surface->arranged_state = {};
+    layer_surface->arranged_mapped = false;
 }
 
 void LayerSurface::new_popup_handler(struct wl_listener* listener, void* data)
@@ -366,18 +391,26 @@ void LayerSurface::output_destroy_handler(struct wl_listener* listener, void*)
     auto* layer_surface = get_listener_data<LayerSurface*>(listener);
     auto* server = get_server(listener);
 
-    auto* client = wl_resource_get_client(layer_surface->surface->resource);
+    // already done by unregister_output if the output was known to the compositor
+    if (layer_surface->output) {
+        layer_surface->detach_from_output(*server);
+    }
+}
 
-    layer_surface->surface->mapped = false;
+void LayerSurface::detach_from_output(Server& server)
+{
+    auto* client = wl_resource_get_client(surface->resource);
+
+    surface->mapped = false;
 
     // if the layer's client has exclusivity, we must focus the first mapped layer of the client,
     // now that this layer is getting unmapped.
     //
     // so we begin searching for it!
-    if (client == server->seat.exclusive_client) {
+    if (client == server.seat.exclusive_client) {
         LayerSurface* layer_surface_to_focus = nullptr;
-        if (client == server->seat.exclusive_client) {
-            for (auto& layer : server->surface_manager.layers) {
+        for (auto& other_output : server.output_manager->outputs) {
+            for (auto& layer : other_output.layers) {
                 for (auto& lf : layer) {
                     if (wl_resource_get_client(lf.surface->resource) == client && lf.surface->mapped) {
                         layer_surface_to_focus = &lf;
@@ -388,15 +421,18 @@ void LayerSurface::output_destroy_handler(struct wl_listener* listener, void*)
                 }
             }
             if (layer_surface_to_focus != nullptr) {
-                server->seat.focus_layer(*server, layer_surface_to_focus->surface);
+                break;
             }
         }
+        if (layer_surface_to_focus != nullptr) {
+            server.seat.focus_layer(server, layer_surface_to_focus->surface);
+        }
     }
-    // we don't have to remove the layer surface from the layer list of the output
-    // because the list is destroyed either way in Output.cpp:output_destroy_handler
-    layer_surface->surface->output = nullptr;
-    layer_surface->output = NullRef<Output>;
-    wlr_layer_surface_v1_close(layer_surface->surface);
+    // the layer surface has already been moved from the layers of the output
+    // to SurfaceManager::orphan_layers by unregister_output
+    surface->output = nullptr;
+    output = NullRef<Output>;
+    wlr_layer_surface_v1_close(surface);
 }
 
 void LayerSurfacePopup::destroy_handler(struct wl_listener* listener, void*)
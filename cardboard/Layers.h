@@ -37,17 +37,25 @@ struct LayerSurface {
     struct wlr_box geometry;
     enum zwlr_layer_shell_v1_layer layer;
     OptionalRef<Output> output;
+    /// The state of the surface the last time it was arranged, see needs_arrange().
+    struct wlr_layer_surface_v1_state arranged_state = {};
+    bool arranged_mapped = false;
+    /// True after the first configure since the surface was created or unmapped. Later configures are sent only if the size changes.
+    bool configured = false;
 
     bool get_surface_under_coords(double lx, double ly, struct wlr_surface*& surface, double& sx, double& sy) const;
-    /// Returns true if \a output is the output of this layer surface.
-    bool is_on_output(Output& output) const;
+    /// Returns true if the committed state changed in a way that affects the arrangement of the layers since it was last arranged.
+    bool needs_arrange() const;
 
-    static void commit_handler(struct wl_listener* listener, void* data);
+    void commit_handler(Server& server, void* data);
     static void destroy_handler(struct wl_listener* listener, void* data);
     static void map_handler(struct wl_listener* listener, void* data);
     static void unmap_handler(struct wl_listener* listener, void* data);
     static void new_popup_handler(struct wl_listener* listener, void* data);
     static void output_destroy_handler(struct wl_listener* listener, void* data);
+
+    /// Closes the surface after its output went away. The surface must already be out of the layers of the output.
+    void detach_from_output(Server& server);
 };
 
 struct LayerSurfacePopup {
@@ -61,6 +69,7 @@ struct LayerSurfacePopup {
     static void map_handler(struct wl_listener* listener, void* data);
 };
 
+/// The layer surfaces of an output, indexed by layer.
 using LayerArray = std::array<std::list<LayerSurface>, 4>;
 
 /// Registers a LayerSurface.
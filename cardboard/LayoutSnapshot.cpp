@@ -0,0 +1,359 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+Copyright (C) 2020 Alexandru-Iulian Magan, Tudor-Ioan Roman, and contributors.
+
+This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 3.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+extern "C" {
+#include <wlr/util/log.h>
+}
+
+#include <cereal/archives/portable_binary.hpp>
+#include <cereal/types/string.hpp>
+#include <cereal/types/vector.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "LayoutSnapshot.h"
+#include "Server.h"
+#include "View.h"
+
+/// \cond IGNORE
+namespace cereal {
+template <typename Archive>
+void serialize(Archive& ar, LayoutSnapshot::View& view)
+{
+    ar(view.app_id, view.title, view.width, view.height, view.vertical_scale, view.x, view.y);
+}
+
+template <typename Archive>
+void serialize(Archive& ar, LayoutSnapshot::Column& column)
+{
+    ar(column.tiles);
+}
+
+template <typename Archive>
+void serialize(Archive& ar, LayoutSnapshot::Workspace& workspace)
+{
+    ar(workspace.index, workspace.scroll_x, workspace.columns, workspace.floating_views);
+}
+
+template <typename Archive>
+void serialize(Archive& ar, LayoutSnapshot& snapshot)
+{
+    ar(snapshot.workspaces);
+}
+}
+/// \endcond
+
+std::optional<std::string> layout_snapshot_path()
+{
+    const char* runtime_dir = getenv("XDG_RUNTIME_DIR");
+    if (runtime_dir == nullptr || runtime_dir[0] == '\0') {
+        return std::nullopt;
+    }
+    // one snapshot per compositor instance. The display is a socket name like wayland-1, not a path
+    const char* display = getenv("WAYLAND_DISPLAY");
+    if (display == nullptr || display[0] == '\0' || std::strchr(display, '/') != nullptr) {
+        return std::nullopt;
+    }
+
+    return std::string(runtime_dir) + "/cardboard-layout-" + display;
+}
+
+static LayoutSnapshot::View snapshot_view(View& view, float vertical_scale)
+{
+    // a fullscreen view remembers its normal size
+    auto [width, height] = view.saved_state ? std::pair { view.saved_state->width, view.saved_state->height } : std::pair { view.geometry.width, view.geometry.height };
+    return {
+        .app_id = view.get_app_id(),
+        .title = view.get_title(),
+        .width = width,
+        .height = height,
+        .vertical_scale = vertical_scale,
+        .x = view.x,
+        .y = view.y,
+    };
+}
+
+LayoutSnapshot take_layout_snapshot(Server& server)
+{
+    LayoutSnapshot snapshot;
+
+    for (auto& workspace : server.output_manager->workspaces) {
+        LayoutSnapshot::Workspace saved { .index = workspace.index, .scroll_x = workspace.scroll_x, .columns = {}, .floating_views = {} };
+
+        for (auto& column : workspace.columns) {
+            LayoutSnapshot::Column saved_column;
+            for (auto& tile : column.tiles) {
+                if (tile.view->mapped) {
+                    saved_column.tiles.push_back(snapshot_view(*tile.view, tile.vertical_scale));
+                }
+            }
+            if (!saved_column.tiles.empty()) {
+                saved.columns.push_back(std::move(saved_column));
+            }
+        }
+        for (auto& view : workspace.floating_views) {
+            if (view.mapped) {
+                saved.floating_views.push_back(snapshot_view(view, 1.0f));
+            }
+        }
+
+        if (!saved.columns.empty() || !saved.floating_views.empty()) {
+            snapshot.workspaces.push_back(std::move(saved));
+        }
+    }
+
+    return snapshot;
+}
+
+bool write_layout_snapshot(const LayoutSnapshot& snapshot, const std::string& path)
+{
+    std::ostringstream buffer;
+    buffer.write(LayoutSnapshot::MAGIC.data(), LayoutSnapshot::MAGIC.size());
+    {
+        cereal::PortableBinaryOutputArchive archive { buffer };
+        archive(LayoutSnapshot::VERSION, snapshot);
+    }
+    std::string data = buffer.str();
+
+    // write to a temporary file first, so that a crash never leaves a truncated snapshot behind.
+    // It is always created anew and never through a symlink, whatever was left at its path is removed.
+    std::string temporary_path = path + ".tmp";
+    unlink(temporary_path.c_str());
+    int fd = open(temporary_path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC, 0600);
+    if (fd == -1) {
+        return false;
+    }
+
+    for (std::size_t written = 0; written < data.size();) {
+        ssize_t result = write(fd, data.data() + written, data.size() - written);
+        if (result == -1 && errno == EINTR) {
+            continue;
+        }
+        if (result == -1) {
+            close(fd);
+            unlink(temporary_path.c_str());
+            return false;
+        }
+        written += result;
+    }
+    if (close(fd) == -1) {
+        unlink(temporary_path.c_str());
+        return false;
+    }
+
+    return rename(temporary_path.c_str(), path.c_str()) == 0;
+}
+
+std::optional<LayoutSnapshot> read_layout_snapshot(const std::string& path)
+{
+    std::ifstream file { path, std::ios::binary };
+    if (!file) {
+        return std::nullopt;
+    }
+
+    // snapshots of older versions are expected after an upgrade, they are not decoded at all
+    std::string magic(LayoutSnapshot::MAGIC.size(), '\0');
+    if (!file.read(magic.data(), magic.size()) || magic != LayoutSnapshot::MAGIC) {
+        wlr_log(WLR_ERROR, "Ignoring %s, it is not a layout snapshot", path.c_str());
+        return std::nullopt;
+    }
+
+    try {
+        cereal::PortableBinaryInputArchive archive { file };
+        uint32_t version;
+        archive(version);
+        if (version != LayoutSnapshot::VERSION) {
+            wlr_log(WLR_INFO, "Ignoring the layout snapshot %s of version %u", path.c_str(), version);
+            return std::nullopt;
+        }
+
+        LayoutSnapshot snapshot;
+        archive(snapshot);
+        return snapshot;
+    } catch (const std::exception& e) {
+        // a corrupt file can also fail an allocation, not only the decoding
+        wlr_log(WLR_ERROR, "Couldn't read the layout snapshot %s: %s", path.c_str(), e.what());
+        return std::nullopt;
+    }
+}
+
+void LayoutRestore::load(const LayoutSnapshot& snapshot)
+{
+    clear();
+    for (const auto& workspace : snapshot.workspaces) {
+        for (int column = 0; column < static_cast<int>(workspace.columns.size()); column++) {
+            const auto& tiles = workspace.columns[column].tiles;
+            for (int row = 0; row < static_cast<int>(tiles.size()); row++) {
+                entries.push_back({ tiles[row], workspace.index, workspace.scroll_x, column, row });
+            }
+        }
+        for (const auto& view : workspace.floating_views) {
+            entries.push_back({ view, workspace.index, workspace.scroll_x, -1, 0 });
+        }
+    }
+    loaded_at_ns = monotonic_ns();
+}
+
+bool LayoutRestore::done() const
+{
+    return entries.empty();
+}
+
+void LayoutRestore::clear()
+{
+    entries.clear();
+    restored_tiles.clear();
+    considered_views.clear();
+}
+
+std::optional<Workspace::IndexType> LayoutRestore::place(Server& server, View& view)
+{
+    if (done()) {
+        return std::nullopt;
+    }
+    if (monotonic_ns() - loaded_at_ns > RESTORE_WINDOW_NS) {
+        wlr_log(WLR_DEBUG, "Giving up restoring %zu views from the layout snapshot", entries.size());
+        clear();
+        return std::nullopt;
+    }
+    if (!considered_views.insert(view.id).second) {
+        return std::nullopt;
+    }
+
+    auto app_id = view.get_app_id();
+    if (app_id.empty()) {
+        return std::nullopt;
+    }
+    auto title = view.get_title();
+
+    auto entry_it = std::find_if(entries.begin(), entries.end(), [&app_id, &title](const auto& entry) {
+        return entry.view.app_id == app_id && entry.view.title == title;
+    });
+    if (entry_it == entries.end()) {
+        entry_it = std::find_if(entries.begin(), entries.end(), [&app_id](const auto& entry) {
+            return entry.view.app_id == app_id;
+        });
+    }
+    if (entry_it == entries.end()) {
+        return std::nullopt;
+    }
+
+    Entry entry = std::move(*entry_it);
+    entries.erase(entry_it);
+
+    auto& output_manager = *server.output_manager;
+    if (entry.workspace < 0 || entry.workspace >= static_cast<Workspace::IndexType>(output_manager.workspaces.size())) {
+        return std::nullopt;
+    }
+    auto& workspace = output_manager.workspaces[entry.workspace];
+
+    // the steps below each arrange the workspace, and the views mapped in the same event loop iteration,
+    // like the programs started together by the config file, can be arranged together
+    if (batch_source == nullptr) {
+        output_manager.begin_layout_transaction();
+        batch_output_manager = &output_manager;
+        batch_source = wl_event_loop_add_idle(server.event_loop, LayoutRestore::end_batch, this);
+    }
+    if (entry.column < 0) {
+        workspace.add_view(output_manager, view, nullptr, true);
+        view.move(output_manager, entry.view.x, entry.view.y);
+        view.resize(entry.view.width, entry.view.height);
+    } else {
+        place_tile(server, workspace, view, entry);
+    }
+    workspace.scroll_x = entry.scroll_x;
+    if (batch_source == nullptr) {
+        end_batch(this);
+    }
+
+    wlr_log(WLR_DEBUG, "Restored view %s on workspace %zd", app_id.c_str(), entry.workspace);
+    if (done()) {
+        clear();
+    }
+
+    return entry.workspace;
+}
+
+void LayoutRestore::end_batch(void* data)
+{
+    auto* restore = static_cast<LayoutRestore*>(data);
+    // idle sources are destroyed after being dispatched
+    restore->batch_source = nullptr;
+
+    if (restore->batch_output_manager != nullptr) {
+        std::exchange(restore->batch_output_manager, nullptr)->end_layout_transaction();
+    }
+}
+
+void LayoutRestore::place_tile(Server& server, ::Workspace& workspace, View& view, const Entry& entry)
+{
+    auto& output_manager = *server.output_manager;
+
+    // find the column restored from the same saved column, or else the nearest restored column on the left
+    Workspace::Column* same_column = nullptr;
+    View* left_neighbour = nullptr;
+    int left_neighbour_column = -1;
+    for (auto& column : workspace.columns) {
+        for (auto& tile : column.tiles) {
+            auto restored = restored_tiles.find(tile.view->id);
+            if (restored == restored_tiles.end()) {
+                continue;
+            }
+
+            int saved_column = restored->second.first;
+            if (saved_column == entry.column) {
+                same_column = &column;
+            } else if (saved_column < entry.column && saved_column >= left_neighbour_column) {
+                left_neighbour_column = saved_column;
+                left_neighbour = column.tiles.back().view;
+            }
+        }
+    }
+
+    // like in Workspace::insert_into_column, make arrange_workspace think the view has been resized
+    view.geometry.width = entry.view.width;
+
+    if (same_column != nullptr) {
+        workspace.add_view(output_manager, view, same_column->tiles.front().view);
+        workspace.insert_into_column(output_manager, view, *same_column);
+
+        // insert_into_column puts the view at the bottom, move it above the tiles that were below it
+        auto& tiles = same_column->tiles;
+        auto inserted = std::prev(tiles.end());
+        auto below = std::find_if(tiles.begin(), inserted, [this, &entry](const auto& tile) {
+            auto restored = restored_tiles.find(tile.view->id);
+            return restored != restored_tiles.end() && restored->second.second > entry.row;
+        });
+        tiles.splice(below, tiles, inserted);
+    } else {
+        workspace.add_view(output_manager, view, left_neighbour);
+        if (left_neighbour == nullptr) {
+            // add_view puts it last, but no restored column comes before this one
+            workspace.columns.splice(workspace.columns.begin(), workspace.columns, workspace.find_column(&view));
+        }
+    }
+
+    auto column_it = workspace.find_column(&view);
+    for (auto& tile : column_it->tiles) {
+        if (tile.view == &view) {
+            tile.vertical_scale = entry.view.vertical_scale;
+        }
+    }
+
+    restored_tiles[view.id] = { entry.column, entry.row };
+}
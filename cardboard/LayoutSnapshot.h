@@ -0,0 +1,138 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+Copyright (C) 2020 Alexandru-Iulian Magan, Tudor-Ioan Roman, and contributors.
+
+This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 3.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef CARDBOARD_LAYOUT_SNAPSHOT_H_INCLUDED
+#define CARDBOARD_LAYOUT_SNAPSHOT_H_INCLUDED
+
+extern "C" {
+#include <wayland-server.h>
+}
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "Workspace.h"
+
+class View;
+struct OutputManager;
+struct Server;
+
+/**
+ * \brief The layout of the workspaces, saved when the compositor stops and restored when it starts again
+ *
+ * Views are recognized by their app id (the class for X11 windows) and title, which is all that survives a restart.
+ */
+struct LayoutSnapshot {
+    /// The first bytes of a snapshot file.
+    static constexpr std::string_view MAGIC = "cardboard-layout";
+    /// Bumped whenever the format changes. Snapshots of other versions are ignored.
+    static constexpr uint32_t VERSION = 1;
+
+    struct View {
+        std::string app_id;
+        std::string title;
+        int width, height; ///< Only the width is restored for tiled views, their height is computed by the column.
+        float vertical_scale; ///< For tiled views.
+        int x, y; ///< For floating views.
+    };
+
+    struct Column {
+        std::vector<View> tiles;
+    };
+
+    struct Workspace {
+        int64_t index;
+        int scroll_x;
+        std::vector<Column> columns;
+        std::vector<View> floating_views;
+    };
+
+    std::vector<Workspace> workspaces;
+};
+
+/**
+ * \brief Returns the path of the snapshot file, in \c XDG_RUNTIME_DIR and named after \c WAYLAND_DISPLAY
+ *
+ * Each compositor instance has its own snapshot, so instances running at the same time don't restore each other's layout.
+ *
+ * Returns \c std::nullopt if \c XDG_RUNTIME_DIR is not set: a predictable path in a shared directory like \c /tmp
+ * would let other users replace the snapshot, or make the compositor overwrite their files through a symlink.
+ */
+std::optional<std::string> layout_snapshot_path();
+
+/// Captures the layout of all the workspaces of \a server.
+LayoutSnapshot take_layout_snapshot(Server& server);
+
+/// Writes \a snapshot to \a path. Returns false on failure.
+bool write_layout_snapshot(const LayoutSnapshot& snapshot, const std::string& path);
+
+/// Reads the snapshot from \a path.
+std::optional<LayoutSnapshot> read_layout_snapshot(const std::string& path);
+
+/**
+ * \brief Puts the views back in their place from a LayoutSnapshot, as they are mapped after a restart
+ *
+ * Each saved view is matched at most once: by app id and title first, then by app id only, since titles often change.
+ * Views are only matched on their first map, during the first #RESTORE_WINDOW_NS after the snapshot was loaded;
+ * after that, new views are placed normally.
+ */
+struct LayoutRestore {
+    static constexpr int64_t RESTORE_WINDOW_NS = 60'000'000'000;
+
+    /// A saved view not matched yet.
+    struct Entry {
+        LayoutSnapshot::View view;
+        Workspace::IndexType workspace;
+        int scroll_x; ///< Of the workspace.
+        int column; ///< Index of the column in the snapshot, -1 for floating views.
+        int row; ///< Index of the tile in the column.
+    };
+
+    std::vector<Entry> entries;
+    /// The snapshot position (column, row) of the restored tiled views, by View::id.
+    std::unordered_map<uint32_t, std::pair<int, int>> restored_tiles;
+    /// Views that have already been considered, so that views mapped again aren't moved.
+    std::unordered_set<uint32_t> considered_views;
+    int64_t loaded_at_ns = 0;
+    /// Idle source that closes the layout transaction of the views restored in this event loop iteration.
+    wl_event_source* batch_source = nullptr;
+    /// The output manager whose layout transaction is open for the restored views, if any.
+    OutputManager* batch_output_manager = nullptr;
+
+    /// Takes the entries to restore from \a snapshot.
+    void load(const LayoutSnapshot& snapshot);
+
+    /// Returns true if there is nothing left to restore.
+    bool done() const;
+
+    /**
+     * \brief Puts \a view where its matching saved view was
+     *
+     * \returns the workspace the view was added to, or \c std::nullopt if it didn't match and it must be placed normally.
+     */
+    std::optional<Workspace::IndexType> place(Server& server, View& view);
+
+    /// Forgets everything, once the restore is over.
+    void clear();
+
+private:
+    /// Arranges the workspaces of the views restored since the last event loop iteration.
+    static void end_batch(void* data);
+    /// Adds \a view as a tile of \a workspace, next to the views restored from the neighbouring saved tiles.
+    void place_tile(Server& server, ::Workspace& workspace, View& view, const Entry& entry);
+};
+
+#endif // CARDBOARD_LAYOUT_SNAPSHOT_H_INCLUDED
@@ -20,14 +20,20 @@ extern "C" {
 #include <wlr/types/wlr_output_layout.h>
 }
 
-#include <algorithm>
 #include <cassert>
+#include <cstddef>
+#include <functional>
 #include <initializer_list>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
 #include <variant>
 
 #include "Cursor.h"
+#include "IntrusiveList.h"
 #include "Keyboard.h"
 #include "Layers.h"
+#include "Pool.h"
 #include "XDGView.h"
 #if HAVE_XWAYLAND
 #include "Xwayland.h"
@@ -37,10 +43,15 @@ struct NoneT {
 };
 struct Server;
 
-/// Constant data for many event listeners.
+/**
+ * \brief The types of objects that can own event listeners.
+ *
+ * Only used when registering listeners: the Listener stores the owner as an untyped pointer
+ * together with the index of its type in this variant.
+ */
 using ListenerData = std::variant<
     NoneT,
-    KeyboardHandleData,
+    KeyboardHandleData*,
     LayerSurface*,
     LayerSurfacePopup*,
     Output*,
@@ -54,6 +65,10 @@ using ListenerData = std::variant<
     XDGView*,
     XDGPopup*>;
 
+/// Index of the owner type \a T in ListenerData.
+template <typename T>
+constexpr std::size_t listener_data_index = ListenerData { std::in_place_type<T> }.index();
+
 /**
  * \brief The Listener is a wrapper around Wayland's \c wl_listener concept.
  *
@@ -62,12 +77,23 @@ using ListenerData = std::variant<
 struct Listener {
     wl_listener listener;
     Server* server;
-    ListenerData listener_data;
+    void* owner; ///< The listener data, nullptr for NoneT.
+    std::size_t owner_type; ///< Index of the type of the listener data in ListenerData.
+    /// Links of this listener in the group of listeners of the same owner.
+    IntrusiveListHook<Listener> owner_link;
 
     Listener(wl_notify_func_t notify, Server* server, ListenerData listener_data)
         : listener { {}, notify }
         , server { server }
-        , listener_data { std::move(listener_data) }
+        , owner { std::visit([](auto data) -> void* {
+            if constexpr (std::is_pointer_v<decltype(data)>) {
+                return data;
+            } else {
+                return nullptr;
+            }
+        },
+                             listener_data) }
+        , owner_type { listener_data.index() }
     {
     }
 };
@@ -84,68 +110,136 @@ inline Server* get_server(wl_listener* listener)
 
 /**
  * \brief Returns the enclosed data from a \a listener.
+ *
+ * \a T must be the pointer type the listener was registered with.
  */
 template <typename T>
-T& get_listener_data(wl_listener* listener)
+T get_listener_data(wl_listener* listener)
 {
+    static_assert(std::is_pointer_v<T>, "listener data is always a pointer");
+
     Listener* l = wl_container_of(listener, l, listener);
-    return std::get<T>(l->listener_data);
+    assert(l->owner_type == listener_data_index<T>);
+    return static_cast<T>(l->owner);
 }
 
+/**
+ * \brief Event handler for listeners whose data type is known at compile time.
+ *
+ * TypedListener::notify calls the member function \a handler on the listener data
+ * directly, without going through get_listener_data. Used for signals that fire often,
+ * like surface commits and pointer motion.
+ *
+ * \code{.cpp}
+ * register_handlers(server, view, {
+ *     { &view->xdg_surface->surface->events.commit, TypedListener<XDGView, &XDGView::surface_commit_handler>::notify },
+ * });
+ * \endcode
+ */
+template <typename T, void (T::*handler)(Server&, void*)>
+struct TypedListener {
+    static void notify(wl_listener* listener, void* data)
+    {
+        Listener* l = wl_container_of(listener, l, listener);
+        (static_cast<T*>(l->owner)->*handler)(*l->server, data);
+    }
+};
+
 /**
  * \brief Holds the event listeners and Listener objects for all the event handlers
  * registered during the lifetime of the compositor.
+ *
+ * Listeners are allocated from a slab and grouped by their owner (the listener data),
+ * so registering, unregistering and clearing the listeners of an owner
+ * only touch the listeners of that owner.
  */
 class ListenerList {
 public:
+    ListenerList() = default;
+    ListenerList(const ListenerList&) = delete;
+    ListenerList(ListenerList&&) = default;
+
     ~ListenerList()
     {
-        for (auto& listener : listeners)
-            wl_list_remove(&listener.listener.link);
+        for (auto& [_, group] : groups) {
+            while (!group.empty()) {
+                auto& listener = group.front();
+                group.remove(listener);
+                wl_list_remove(&listener.listener.link);
+                pool.destroy(&listener);
+            }
+        }
     }
 
     /// Registers a \a listener for a given \a signal.
     wl_listener* add_listener(wl_signal* signal, Listener&& listener)
     {
-        listeners.push_back(std::move(listener));
-        wl_signal_add(signal, &listeners.back().listener);
+        Listener* node = pool.create<Listener>(std::move(listener));
+        groups[{ node->owner_type, node->owner }].push_back(*node);
+        wl_signal_add(signal, &node->listener);
 
-        return &listeners.back().listener;
+        return &node->listener;
     }
 
     /// Unregisters a Listener object associated with a ray Wayland \a raw_listener.
     void remove_listener(wl_listener* raw_listener)
     {
+        Listener* node = wl_container_of(raw_listener, node, listener);
         wl_list_remove(&raw_listener->link);
 
-        listeners.remove_if([raw_listener](auto& listener) { return raw_listener == &listener.listener; });
+        auto group_it = groups.find({ node->owner_type, node->owner });
+        assert(group_it != groups.end());
+        group_it->second.remove(*node);
+        if (group_it->second.empty()) {
+            groups.erase(group_it);
+        }
+
+        pool.destroy(node);
     }
 
     /// Unregisters all event listeners associated with \a owner (i.e. \a owner is the listener data).
     template <typename T>
     void clear_listeners(T owner)
     {
-        bool it_works = false;
-        auto next = listeners.end();
-        auto it = listeners.begin();
-        while (it != listeners.end()) {
-            next = std::next(it);
-
-            if (auto pval = std::get_if<T>(&it->listener_data)) {
-                if (*pval == owner) {
-                    remove_listener(&it->listener);
-                    it_works = true;
-                }
-            }
-
-            it = next;
+        auto group_it = groups.find({ listener_data_index<T>, owner });
+        assert(group_it != groups.end() && "this object doesn't have listeners");
+        if (group_it == groups.end()) {
+            return;
         }
 
-        assert(it_works && "this object doesn't have listeners");
+        auto& group = group_it->second;
+        while (!group.empty()) {
+            auto& listener = group.front();
+            group.remove(listener);
+            wl_list_remove(&listener.listener.link);
+            pool.destroy(&listener);
+        }
+        groups.erase(group_it);
     }
 
 private:
-    std::list<Listener> listeners;
+    /// Identifies the owner of a listener by the type of its data and the object it points to.
+    struct OwnerKey {
+        std::size_t type_index;
+        const void* object;
+
+        bool operator==(const OwnerKey& other) const
+        {
+            return type_index == other.type_index && object == other.object;
+        }
+    };
+
+    struct OwnerKeyHash {
+        std::size_t operator()(const OwnerKey& key) const
+        {
+            return std::hash<const void*> {}(key.object) ^ (key.type_index * 0x9e3779b97f4a7c15ull);
+        }
+    };
+
+    using ListenerGroup = IntrusiveList<Listener, MemberHook<Listener, &Listener::owner_link>>;
+
+    ObjectPool<Listener, Listener> pool;
+    std::unordered_map<OwnerKey, ListenerGroup, OwnerKeyHash> groups;
 };
 
 struct ListenerPair {
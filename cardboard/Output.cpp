@@ -51,22 +51,19 @@ void register_output(Server& server, Output&& output_)
     register_handlers(server,
                       &output,
                       {
-                          { &output.wlr_output_damage->events.frame, Output::frame_handler },
-                          { &output.wlr_output->events.present, Output::present_handler },
+                          { &output.wlr_output_damage->events.frame, TypedListener<Output, &Output::frame_handler>::notify },
+                          { &output.wlr_output->events.present, TypedListener<Output, &Output::present_handler>::notify },
                           { &output.wlr_output->events.commit, Output::commit_handler },
                           { &output.wlr_output->events.mode, Output::mode_handler },
                           { &output.wlr_output->events.destroy, Output::destroy_handler },
                       });
 }
 
-/// Arrange the workspace associated with \a output.
-static void arrange_output(Server& server, Output& output)
+void arrange_output(Server& server, Output& output)
 {
-    auto ws_it = std::find_if(server.output_manager->workspaces.begin(), server.output_manager->workspaces.end(), [&output](const auto& other) { return other.output && other.output.raw_pointer() == &output; });
-    if (ws_it == server.output_manager->workspaces.end()) {
-        return;
-    }
-    ws_it->arrange_workspace(*(server.output_manager));
+    output.workspace.and_then([&server](auto& ws) {
+        ws.arrange_workspace(*(server.output_manager));
+    });
 }
 
 static void render_surface(struct wlr_surface* surface, int sx, int sy, void* data)
@@ -147,43 +144,25 @@ static void render_workspace(Server& server, Workspace& ws, struct wlr_output* w
 
 static void render_floating(Server& server, Workspace& ws, OptionalRef<View> ancestor, struct wlr_output* wlr_output, struct wlr_renderer* renderer, struct timespec* now)
 {
-    auto focused_view = server.seat.get_focused_view();
-
-    bool focused_floating = false;
-    for (const auto& view : ws.floating_views) {
-        if ((!view->mapped) || (ancestor && !view->is_transient_for(ancestor.unwrap()) && view != ancestor.raw_pointer())) {
+    // paint from the bottom of the stack to the top, the focused view is always on top
+    for (auto& view : ws.floating_views.reversed()) {
+        if (!view.mapped) {
             continue;
         }
-
-        if (view == focused_view.raw_pointer()) {
-            focused_floating = true;
+        if (ancestor && !view.is_transient_for(ancestor.unwrap()) && &view != ancestor.raw_pointer()) {
             continue;
         }
 
         RenderData rdata = {
             .output = wlr_output,
             .renderer = renderer,
-            .lx = view->x,
-            .ly = view->y,
-            .when = now,
-            .server = &server
-        };
-
-        view->for_each_surface(render_surface, &rdata);
-    }
-
-    if (focused_floating) {
-        auto& focused_view_r = focused_view.unwrap();
-        RenderData rdata = {
-            .output = wlr_output,
-            .renderer = renderer,
-            .lx = focused_view_r.x,
-            .ly = focused_view_r.y,
+            .lx = view.x,
+            .ly = view.y,
             .when = now,
             .server = &server
         };
 
-        focused_view_r.for_each_surface(render_surface, &rdata);
+        view.for_each_surface(render_surface, &rdata);
     }
 }
 
@@ -191,7 +170,7 @@ static void render_layer(Server& server, LayerArray::value_type& surfaces, Outpu
 {
     const struct wlr_box* output_box = server.output_manager->get_output_box(output);
     for (const auto& surface : surfaces) {
-        if (!surface.surface->mapped || !surface.is_on_output(output)) {
+        if (!surface.surface->mapped) {
             continue;
         }
 
@@ -209,14 +188,14 @@ static void render_layer(Server& server, LayerArray::value_type& surfaces, Outpu
 }
 
 #if HAVE_XWAYLAND
-static void render_xwayland_or_surface(Server& server, struct wlr_output* wlr_output, struct wlr_renderer* renderer, struct timespec* now)
+static void render_xwayland_or_surface(Server& server, Output& output, struct wlr_renderer* renderer, struct timespec* now)
 {
-    for (const auto& xwayland_or_surface : server.surface_manager.xwayland_or_surfaces) {
-        if (!xwayland_or_surface->mapped || !xwayland_or_surface->xwayland_surface->surface) {
+    for (auto* xwayland_or_surface : output.xwayland_or_surfaces) {
+        if (!xwayland_or_surface->xwayland_surface->surface) {
             continue;
         }
         RenderData rdata = {
-            .output = wlr_output,
+            .output = output.wlr_output,
             .renderer = renderer,
             .lx = xwayland_or_surface->lx,
             .ly = xwayland_or_surface->ly,
@@ -254,14 +233,62 @@ static void render_xwayland_or_surface(Server& server, struct wlr_output* wlr_ou
     return static_cast<double>(delta.tv_sec) + static_cast<double>(delta.tv_nsec) / 1000000000.0;
 }
 
-void Output::frame_handler(struct wl_listener* listener, void*)
+/// Renders the views of \a ws, shown on \a output, with the surfaces that stack above them.
+static void render_shown_workspace(Server& server, Output& output, Workspace& ws, struct wlr_renderer* renderer, struct timespec* now)
 {
-    Server* server = get_server(listener);
-    auto* output = get_listener_data<Output*>(listener);
-    auto* wlr_output = output->wlr_output;
-    struct wlr_renderer* renderer = server->renderer;
+    if (ws.fullscreen_view) {
+        render_workspace(server, ws, output.wlr_output, renderer, now);
+#if HAVE_XWAYLAND
+        render_xwayland_or_surface(server, output, renderer, now);
+#endif
+        render_floating(server, ws, ws.fullscreen_view, output.wlr_output, renderer, now);
+    } else {
+
+        if (auto focused_view_ptr = server.seat.get_focused_view(); focused_view_ptr) {
+            auto focused_view = focused_view_ptr.raw_pointer();
+
+            if (auto column_it = ws.find_column(focused_view); column_it != ws.columns.end()) {
+                wlr_box column_dimensions = {
+                    .x = focused_view->x + focused_view->geometry.x - server.config.gap / 2,
+                    .y = focused_view->y + focused_view->geometry.y - server.config.gap / (column_it->tiles.size() == 1 ? 1 : 2),
+                    .width = focused_view->target_width + server.config.gap,
+                    .height = focused_view->target_height + (column_it->tiles.size() == 1 ? 2 : 1) * server.config.gap
+                };
+
+                std::array<float, 9> matrix;
+                wl_output_transform transform = wlr_output_transform_invert(
+                    focused_view->get_surface()->current.transform);
+                wlr_matrix_project_box(matrix.data(), &column_dimensions, transform, 0, output.wlr_output->transform_matrix);
+
+                auto focus_color = server.config.focus_color;
+                // premultiply components
+                focus_color.r *= focus_color.a;
+                focus_color.g *= focus_color.a;
+                focus_color.b *= focus_color.a;
+                wlr_render_quad_with_matrix(
+                    renderer,
+                    reinterpret_cast<float*>(&focus_color),
+                    matrix.data());
+            }
+        }
+
+        render_workspace(server, ws, output.wlr_output, renderer, now);
+        wlr_renderer_scissor(renderer, nullptr);
+
+#if HAVE_XWAYLAND
+        render_xwayland_or_surface(server, output, renderer, now);
+#endif
+
+        render_floating(server, ws, NullRef<View>, output.wlr_output, renderer, now);
+        render_layer(server, output.layers[ZWLR_LAYER_SHELL_V1_LAYER_TOP], output, renderer, now);
+    }
+}
+
+void Output::frame_handler(Server& server, void*)
+{
+    struct wlr_renderer* renderer = server.renderer;
 
-    server->seat.update_swipe(*server);
+    server.seat.update_swipe(server);
 
     struct timespec now;
     clock_gettime(CLOCK_MONOTONIC, &now);
@@ -270,13 +297,13 @@ void Output::frame_handler(struct wl_listener* listener, void*)
     bool needs_frame;
     pixman_region32_t damage;
     pixman_region32_init(&damage);
-    if (!wlr_output_damage_attach_render(output->wlr_output_damage, &needs_frame, &damage)) {
+    if (!wlr_output_damage_attach_render(wlr_output_damage, &needs_frame, &damage)) {
         wlr_log(WLR_ERROR, "cannot make damage output current");
         return;
     }
 
     if (!needs_frame) {
-        wlr_output_rollback(output->wlr_output);
+        wlr_output_rollback(wlr_output);
         goto damage_finish;
     }
 
@@ -290,96 +317,65 @@ void Output::frame_handler(struct wl_listener* listener, void*)
         wlr_renderer_clear(renderer, color.data());
     }
 
-    {
-        int workspaces_number = 0;
-        int fullscreen_workspaces_number = 0;
-
-        for (auto& ws : server->output_manager->workspaces) {
-            if (ws.output.raw_pointer() == output) {
-                workspaces_number++;
-                fullscreen_workspaces_number += static_cast<bool>(ws.fullscreen_view);
-            }
-        }
-
-        if (fullscreen_workspaces_number != workspaces_number - fullscreen_workspaces_number) {
-            render_layer(*server, server->surface_manager.layers[ZWLR_LAYER_SHELL_V1_LAYER_BACKGROUND], *output, renderer, &now);
-            render_layer(*server, server->surface_manager.layers[ZWLR_LAYER_SHELL_V1_LAYER_BOTTOM], *output, renderer, &now);
-        }
-    }
-
-    for (auto& ws : server->output_manager->workspaces) {
-
-        if (ws.output.raw_pointer() != output) {
-            continue;
-        }
-
-        if (ws.fullscreen_view) {
-            render_workspace(*server, ws, wlr_output, renderer, &now);
-#if HAVE_XWAYLAND
-            render_xwayland_or_surface(*server, wlr_output, renderer, &now);
-#endif
-            render_floating(*server, ws, ws.fullscreen_view, wlr_output, renderer, &now);
-        } else {
-
-            if (auto focused_view_ptr = server->seat.get_focused_view(); focused_view_ptr) {
-                auto focused_view = focused_view_ptr.raw_pointer();
-
-                if (auto column_it = ws.find_column(focused_view); column_it != ws.columns.end()) {
-                    wlr_box column_dimensions = {
-                        .x = focused_view->x + focused_view->geometry.x - server->config.gap / 2,
-                        .y = focused_view->y + focused_view->geometry.y - server->config.gap / (column_it->tiles.size() == 1 ? 1 : 2),
-                        .width = focused_view->target_width + server->config.gap,
-                        .height = focused_view->target_height + (column_it->tiles.size() == 1 ? 2 : 1) * server->config.gap
-                    };
-
-                    std::array<float, 9> matrix;
-                    wl_output_transform transform = wlr_output_transform_invert(
-                        focused_view->get_surface()->current.transform);
-                    wlr_matrix_project_box(matrix.data(), &column_dimensions, transform, 0, wlr_output->transform_matrix);
-
-                    auto focus_color = server->config.focus_color;
-                    // premultiply components
-                    focus_color.r *= focus_color.a;
-                    focus_color.g *= focus_color.a;
-                    focus_color.b *= focus_color.a;
-                    wlr_render_quad_with_matrix(
-                        renderer,
-                        reinterpret_cast<float*>(&focus_color),
-                        matrix.data());
-                }
-            }
-
-            render_workspace(*server, ws, wlr_output, renderer, &now);
-            wlr_renderer_scissor(renderer, nullptr);
+    if (workspace) {
+        render_layer(server, layers[ZWLR_LAYER_SHELL_V1_LAYER_BACKGROUND], *this, renderer, &now);
+        render_layer(server, layers[ZWLR_LAYER_SHELL_V1_LAYER_BOTTOM], *this, renderer, &now);
 
-#if HAVE_XWAYLAND
-            render_xwayland_or_surface(*server, wlr_output, renderer, &now);
-#endif
-
-            render_floating(*server, ws, NullRef<View>, wlr_output, renderer, &now);
-            render_layer(*server, server->surface_manager.layers[ZWLR_LAYER_SHELL_V1_LAYER_TOP], *output, renderer, &now);
+        // the workspaces being switched away from slide out while the new one slides in
+        for (Workspace* outgoing_workspace : outgoing_workspaces) {
+            render_shown_workspace(server, *this, *outgoing_workspace, renderer, &now);
         }
+        render_shown_workspace(server, *this, workspace.unwrap(), renderer, &now);
     }
 
-    render_layer(*server, server->surface_manager.layers[ZWLR_LAYER_SHELL_V1_LAYER_OVERLAY], *output, renderer, &now);
+    render_layer(server, layers[ZWLR_LAYER_SHELL_V1_LAYER_OVERLAY], *this, renderer, &now);
 
     // in case of software rendered cursor, render it
     wlr_output_render_software_cursors(wlr_output, nullptr);
 
     // swap buffers and show frame
     wlr_renderer_end(renderer);
-    wlr_output_commit(wlr_output);
+    if (wlr_output_commit(wlr_output)) {
+        server.startup_trace.record_first_frame();
+    }
 
 damage_finish:
     pixman_region32_fini(&damage);
 }
 
-void Output::present_handler(struct wl_listener* listener, void* data)
+void Output::present_handler(Server&, void* data)
 {
-    auto* output = get_listener_data<Output*>(listener);
     auto* event = static_cast<struct wlr_output_event_present*>(data);
 
-    output->last_present = *event->when;
+    last_present = *event->when;
+}
+
+void unregister_output(Server& server, Output& output)
+{
+    publish_event(server, { .type = libcardboard::events::Type::OutputRemoved, .output = output.wlr_output->name });
+    server.output_manager->mark_outputs_changed();
+
+    // deactivate removes the workspace from the list
+    for (Workspace* outgoing_workspace : std::vector(output.outgoing_workspaces)) {
+        outgoing_workspace->deactivate();
+    }
+    output.workspace.and_then([](auto& ws) {
+        ws.deactivate();
+    });
+
+    // the layer surfaces live until their clients destroy them
+    std::list<LayerSurface> detached_layers;
+    for (auto& layer : output.layers) {
+        detached_layers.splice(detached_layers.end(), layer);
+    }
+    for (auto& layer_surface : detached_layers) {
+        layer_surface.detach_from_output(server);
+    }
+    server.surface_manager.orphan_layers.splice(server.surface_manager.orphan_layers.end(), detached_layers);
+
+    output.wlr_output->data = nullptr;
+    server.listeners.clear_listeners(&output);
+    server.output_manager->remove_output_from_list(output);
 }
 
 void Output::destroy_handler(struct wl_listener* listener, void*)
@@ -387,15 +383,7 @@ void Output::destroy_handler(struct wl_listener* listener, void*)
     Server* server = get_server(listener);
     auto* output = get_listener_data<Output*>(listener);
 
-    for (auto& ws : server->output_manager->workspaces) {
-        if (ws.output && &ws.output.unwrap() == output) {
-            ws.deactivate();
-            break;
-        }
-    }
-
-    server->listeners.clear_listeners(output);
-    server->output_manager->remove_output_from_list(*output);
+    unregister_output(*server, *output);
 }
 
 void Output::commit_handler(struct wl_listener* listener, void* data)
@@ -405,9 +393,14 @@ void Output::commit_handler(struct wl_listener* listener, void* data)
     auto* event = static_cast<struct wlr_output_event_commit*>(data);
 
     if (event->committed & (WLR_OUTPUT_STATE_SCALE | WLR_OUTPUT_STATE_TRANSFORM)) {
+        server->output_manager->mark_outputs_changed();
         arrange_layers(*server, *output);
         arrange_output(*server, *output);
     }
+    if (event->committed & WLR_OUTPUT_STATE_SCALE) {
+        cursor_load_theme(server->seat.cursor, output->wlr_output->scale);
+        cursor_refresh_image(*server, server->seat, server->seat.cursor);
+    }
 }
 
 void Output::mode_handler(struct wl_listener* listener, void*)
@@ -415,6 +408,7 @@ void Output::mode_handler(struct wl_listener* listener, void*)
     auto* server = get_server(listener);
     auto* output = get_listener_data<Output*>(listener);
 
+    server->output_manager->mark_outputs_changed();
     arrange_layers(*server, *output);
     arrange_output(*server, *output);
 }
@@ -18,8 +18,10 @@ extern "C" {
 }
 
 #include <array>
+#include <vector>
 
 #include "Layers.h"
+#include "NotNull.h"
 #include "Server.h"
 
 /**
@@ -29,18 +31,37 @@ extern "C" {
  * Outputs are displays.
  */
 
+struct XwaylandORSurface;
+
 struct Output {
     struct wlr_output* wlr_output;
     struct wlr_output_damage* wlr_output_damage;
     struct wlr_box usable_area;
 
+    /// The workspace shown on this output, maintained by Workspace::activate and Workspace::deactivate.
+    OptionalRef<Workspace> workspace;
+    /**
+     * \brief The workspaces sliding out of this output, oldest first
+     *
+     * When switching workspaces, the new one is activated right away, but the previous one is only deactivated
+     * when its animation ends. It is still drawn until then. Switching again before the animation ends
+     * adds another one.
+     */
+    std::vector<NotNullPointer<Workspace>> outgoing_workspaces;
+
+    /// Layer surfaces shown on this output.
+    LayerArray layers;
+
+    /// Mapped Xwayland override redirect surfaces that intersect this output, from the oldest to the newest.
+    std::vector<XwaylandORSurface*> xwayland_or_surfaces;
+
     /// Time of last presentation. Use it to calculate the delta time.
     struct timespec last_present;
 
     /// Executed for each frame render per output.
-    static void frame_handler(struct wl_listener* listener, void* data);
+    void frame_handler(Server& server, void* data);
     /// Executed as soon as the first pixel is put on the screen;
-    static void present_handler(struct wl_listener* listener, void* data);
+    void present_handler(Server& server, void* data);
     /// Executed when the output is detached.
     static void destroy_handler(struct wl_listener* listener, void* data);
     /// Executed when the output changes fields (transform, scale etc).
@@ -52,4 +73,14 @@ struct Output {
 /// Registers event listeners and does bookkeeping for a newly added output.
 void register_output(Server& server, Output&& output);
 
+/**
+ * \brief Forgets \a output, when it is destroyed or disabled.
+ *
+ * Its workspace is deactivated and its layer surfaces are closed. \a output is freed.
+ */
+void unregister_output(Server& server, Output& output);
+
+/// Arranges the workspace associated with \a output.
+void arrange_output(Server& server, Output& output);
+
 #endif // CARDBOARD_OUTPUT_H_INCLUDED
@@ -14,6 +14,9 @@ extern "C" {
 #include <wlr/util/log.h>
 }
 
+#include <algorithm>
+#include <cassert>
+
 #include "Helpers.h"
 #include "Layers.h"
 #include "Listener.h"
@@ -25,6 +28,7 @@ void OutputManager::register_handlers(Server& server, struct wl_signal* new_outp
     ::register_handlers(server, this, {
                                           { new_output, OutputManager::new_output_handler },
                                           { &output_layout->events.add, OutputManager::output_layout_add_handler },
+                                          { &output_layout->events.change, OutputManager::output_layout_change_handler },
                                       });
 }
 
@@ -109,11 +113,40 @@ void OutputManager::output_layout_add_handler(struct wl_listener* listener, void
 
     ws_to_assign->activate(output);
     arrange_layers(*server, output);
+    server->output_manager->mark_outputs_changed();
+
+    // the new output has no cursor image yet
+    cursor_load_theme(server->seat.cursor, output.wlr_output->scale);
+    cursor_refresh_image(*server, server->seat, server->seat.cursor);
+
+    publish_event(*server, { .type = libcardboard::events::Type::OutputAdded, .workspace = static_cast<int32_t>(ws_to_assign->index), .output = output.wlr_output->name });
 
     // the output doesn't need to be exposed as a wayland global
     // because wlr_output_layout does it for us already
 }
 
+void OutputManager::output_layout_change_handler(struct wl_listener* listener, void*)
+{
+    Server* server = get_server(listener);
+
+    server->surface_manager.update_xwayland_or_surface_outputs(*server->output_manager);
+    if (!server->output_manager->applying_configuration) {
+        server->output_manager->update_output_manager_config();
+    }
+}
+
+void OutputManager::disabled_output_destroy_handler(struct wl_listener* listener, void* data)
+{
+    auto* server = get_server(listener);
+    auto* wlr_output = static_cast<struct wlr_output*>(data);
+    auto& disabled_outputs = server->output_manager->disabled_outputs;
+
+    disabled_outputs.erase(std::remove_if(disabled_outputs.begin(), disabled_outputs.end(), [wlr_output](const auto& disabled) { return disabled.first == wlr_output; }),
+                           disabled_outputs.end());
+    server->listeners.remove_listener(listener);
+    server->output_manager->update_output_manager_config();
+}
+
 Workspace& OutputManager::create_workspace(Server* server)
 {
     workspaces.push_back({ .server = server, .index = static_cast<Workspace::IndexType>(workspaces.size()) });
@@ -132,12 +165,228 @@ void OutputManager::set_dirty()
     }
 }
 
-void OutputManager::output_manager_apply_handler([[maybe_unused]] wl_listener* listener, [[maybe_unused]] void* data)
+void OutputManager::mark_changed(Workspace& workspace)
+{
+    workspace.generation = ++generation;
+    publish_event(*workspace.server, { .type = libcardboard::events::Type::WorkspaceChanged, .workspace = static_cast<int32_t>(workspace.index) });
+}
+
+void OutputManager::mark_outputs_changed()
+{
+    outputs_generation = ++generation;
+}
+
+void OutputManager::begin_layout_transaction()
+{
+    layout_transaction_depth++;
+}
+
+void OutputManager::end_layout_transaction()
+{
+    assert(layout_transaction_depth > 0);
+    if (--layout_transaction_depth > 0) {
+        return;
+    }
+
+    auto arrangements = std::move(deferred_arrangements);
+    deferred_arrangements.clear();
+    for (auto [index, animate] : arrangements) {
+        workspaces[index].arrange_workspace(*this, animate);
+    }
+}
+
+bool OutputManager::defer_arrangement(const Workspace& workspace, bool animate)
+{
+    if (layout_transaction_depth == 0) {
+        return false;
+    }
+
+    auto it = std::find_if(deferred_arrangements.begin(), deferred_arrangements.end(), [&workspace](const auto& arrangement) {
+        return arrangement.first == workspace.index;
+    });
+    if (it != deferred_arrangements.end()) {
+        it->second = it->second || animate;
+    } else {
+        deferred_arrangements.emplace_back(workspace.index, animate);
+    }
+
+    return true;
+}
+
+void OutputManager::update_output_manager_config()
+{
+    auto* config = wlr_output_configuration_v1_create();
+    if (!config) {
+        return;
+    }
+
+    for (auto& output : outputs) {
+        auto* head = wlr_output_configuration_head_v1_create(config, output.wlr_output);
+        const auto* box = wlr_output_layout_get_box(output_layout, output.wlr_output);
+        if (head && box) {
+            head->state.x = box->x;
+            head->state.y = box->y;
+        }
+    }
+    for (auto [wlr_output, _] : disabled_outputs) {
+        wlr_output_configuration_head_v1_create(config, wlr_output);
+    }
+
+    wlr_output_manager_v1_set_configuration(output_manager_v1, config);
+}
+
+/// Stages the state of \a head on its output, without committing it.
+static void stage_output_head(struct wlr_output_configuration_head_v1* head)
+{
+    auto* wlr_output = head->state.output;
+
+    wlr_output_enable(wlr_output, head->state.enabled);
+    if (!head->state.enabled) {
+        return;
+    }
+
+    if (head->state.mode) {
+        wlr_output_set_mode(wlr_output, head->state.mode);
+    } else {
+        wlr_output_set_custom_mode(wlr_output, head->state.custom_mode.width, head->state.custom_mode.height, head->state.custom_mode.refresh);
+    }
+    wlr_output_set_transform(wlr_output, head->state.transform);
+    wlr_output_set_scale(wlr_output, head->state.scale);
+}
+
+/**
+ * \brief Stages every head of \a config and tests it on its output.
+ *
+ * The staged state is rolled back if a test fails or if \a keep is false.
+ *
+ * \return true if every output accepts its new state
+ */
+static bool test_output_config(struct wlr_output_configuration_v1* config, bool keep)
+{
+    bool ok = true;
+    struct wlr_output_configuration_head_v1* head;
+    wl_list_for_each(head, &config->heads, link)
+    {
+        stage_output_head(head);
+        if (!wlr_output_test(head->state.output)) {
+            wlr_log(WLR_ERROR, "output %s rejected its new configuration", head->state.output->name);
+            ok = false;
+            break;
+        }
+    }
+
+    if (!ok || !keep) {
+        wl_list_for_each(head, &config->heads, link)
+        {
+            wlr_output_rollback(head->state.output);
+        }
+    }
+
+    return ok;
+}
+
+/// Removes \a output from the layout, keeping it advertised as disabled.
+static void disable_output(Server& server, Output& output)
 {
+    auto* wlr_output = output.wlr_output;
+    auto* wlr_output_damage = output.wlr_output_damage;
+
+    // the damage can only go once the frame listener on it is removed, and \a output is freed by then
+    unregister_output(server, output);
+    wlr_output_damage_destroy(wlr_output_damage);
+    wlr_output_layout_remove(server.output_manager->output_layout, wlr_output);
+
+    auto* listener = server.listeners.add_listener(&wlr_output->events.destroy,
+                                                   Listener { OutputManager::disabled_output_destroy_handler, &server, server.output_manager.get() });
+    server.output_manager->disabled_outputs.emplace_back(wlr_output, listener);
 }
 
-void OutputManager::output_manager_test_handler([[maybe_unused]] wl_listener* listener, [[maybe_unused]] void* data)
+/// Adds a disabled output back to the layout, where OutputManager::output_layout_add_handler picks it up.
+static void enable_output(Server& server, struct wlr_output* wlr_output, int x, int y)
 {
+    auto& disabled_outputs = server.output_manager->disabled_outputs;
+    auto it = std::find_if(disabled_outputs.begin(), disabled_outputs.end(), [wlr_output](const auto& disabled) { return disabled.first == wlr_output; });
+    if (it != disabled_outputs.end()) {
+        server.listeners.remove_listener(it->second);
+        disabled_outputs.erase(it);
+    }
+
+    wlr_output_layout_add(server.output_manager->output_layout, wlr_output, x, y);
+}
+
+void OutputManager::output_manager_apply_handler(wl_listener* listener, void* data)
+{
+    auto* server = get_server(listener);
+    auto* config = static_cast<struct wlr_output_configuration_v1*>(data);
+    auto& output_manager = *server->output_manager;
+
+    if (!test_output_config(config, true)) {
+        wlr_output_configuration_v1_send_failed(config);
+        wlr_output_configuration_v1_destroy(config);
+        return;
+    }
+
+    // the mode and commit handlers of the outputs that changed arrange their layers,
+    // and their workspaces are arranged once, when the transaction ends
+    output_manager.applying_configuration = true;
+    output_manager.begin_layout_transaction();
+
+    bool ok = true;
+    struct wlr_output_configuration_head_v1* head;
+    wl_list_for_each(head, &config->heads, link)
+    {
+        auto* wlr_output = head->state.output;
+        auto* output = static_cast<Output*>(wlr_output->data);
+
+        if (!head->state.enabled) {
+            if (output) {
+                disable_output(*server, *output);
+            }
+            ok = wlr_output_commit(wlr_output) && ok;
+            continue;
+        }
+
+        if (!wlr_output_commit(wlr_output)) {
+            wlr_log(WLR_ERROR, "couldn't commit the configuration of output %s", wlr_output->name);
+            ok = false;
+            continue;
+        }
+
+        if (!output) {
+            enable_output(*server, wlr_output, head->state.x, head->state.y);
+            continue;
+        }
+
+        const auto* box = wlr_output_layout_get_box(output_manager.output_layout, wlr_output);
+        if (box->x != head->state.x || box->y != head->state.y) {
+            wlr_output_layout_move(output_manager.output_layout, wlr_output, head->state.x, head->state.y);
+            output_manager.mark_outputs_changed();
+            arrange_output(*server, *output);
+        }
+    }
+
+    output_manager.end_layout_transaction();
+    output_manager.applying_configuration = false;
+    output_manager.update_output_manager_config();
+
+    if (ok) {
+        wlr_output_configuration_v1_send_succeeded(config);
+    } else {
+        wlr_output_configuration_v1_send_failed(config);
+    }
+    wlr_output_configuration_v1_destroy(config);
+}
+
+void OutputManager::output_manager_test_handler([[maybe_unused]] wl_listener* listener, void* data)
+{
+    auto* config = static_cast<struct wlr_output_configuration_v1*>(data);
+
+    if (test_output_config(config, false)) {
+        wlr_output_configuration_v1_send_succeeded(config);
+    } else {
+        wlr_output_configuration_v1_send_failed(config);
+    }
+    wlr_output_configuration_v1_destroy(config);
 }
 
 OutputManagerInstance create_output_manager(Server* server)
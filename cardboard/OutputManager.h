@@ -16,8 +16,11 @@ extern "C" {
 #include <wlr/types/wlr_output_management_v1.h>
 }
 
+#include <cstdint>
+#include <deque>
 #include <list>
 #include <memory>
+#include <utility>
 #include <vector>
 
 #include "NotNull.h"
@@ -31,7 +34,25 @@ struct OutputManager {
     wlr_output_manager_v1* output_manager_v1;
     wlr_output_layout* output_layout;
     std::list<Output> outputs;
-    std::vector<Workspace> workspaces;
+    /// A deque, so that references to workspaces (like Output::workspace) stay valid when workspaces are created.
+    std::deque<Workspace> workspaces;
+
+    /**
+     * \brief Generation of the layout, incremented on every change of a workspace or of the outputs.
+     *
+     * Lets IPC clients ask for the changes since a generation, see libcardboard::state.
+     */
+    uint64_t generation = 0;
+    /// The generation of the last change of the outputs.
+    uint64_t outputs_generation = 0;
+    /**
+     * \brief Outputs disabled by an output configuration client, with the listener of their destroy event.
+     *
+     * They have no Output and aren't in \a output_layout, but they are still advertised to the clients so that they can be enabled again.
+     */
+    std::vector<std::pair<struct wlr_output*, struct wl_listener*>> disabled_outputs;
+    /// True while a configuration is being applied, to advertise the new state only once at the end.
+    bool applying_configuration = false;
 
     void register_handlers(Server& server, struct wl_signal* new_output);
 
@@ -56,11 +77,46 @@ struct OutputManager {
 
     void set_dirty();
 
+    /// Records a change in the layout of \a workspace and notifies the subscribed IPC clients. Called per arrangement, not per view move.
+    void mark_changed(Workspace& workspace);
+    /// Records that an output has been added or removed, or that its geometry changed.
+    void mark_outputs_changed();
+
+    /**
+     * \brief Opens a layout transaction.
+     *
+     * While a transaction is open, Workspace::arrange_workspace only records that the workspace
+     * needs to be arranged. The recorded workspaces are arranged once, when the outermost transaction is closed.
+     * Transactions can be nested.
+     */
+    void begin_layout_transaction();
+    /// Closes a layout transaction opened by OutputManager::begin_layout_transaction.
+    void end_layout_transaction();
+    /**
+     * \brief Records that \a workspace needs to be arranged if a layout transaction is open.
+     *
+     * \return true if the arrangement has been deferred
+     */
+    bool defer_arrangement(const Workspace& workspace, bool animate);
+
+    /// Sends the current state of the outputs to the output configuration clients (wlr-output-management).
+    void update_output_manager_config();
+
+    /**
+     * \brief Applies a configuration sent by an output configuration client, like kanshi or wlr-randr.
+     *
+     * All the outputs are tested before any of them is committed, so an invalid configuration changes nothing.
+     * The workspaces are arranged once at the end, and only those on outputs that changed.
+     */
     static void output_manager_apply_handler(wl_listener* listener, void* data);
 
+    /// Tells an output configuration client whether its configuration would be applied, without applying it.
     static void output_manager_test_handler(wl_listener* listener, void* data);
 
 private:
+    int layout_transaction_depth = 0;
+    /// Indices of the workspaces to arrange at the end of the layout transaction, and whether to animate them.
+    std::vector<std::pair<Workspace::IndexType, bool>> deferred_arrangements;
 
     /**
     * \brief Executed when a new output (monitor) is attached.
@@ -80,6 +136,12 @@ private:
     * The compositor then assigns a workspace to this output, creating one if none is available.
     */
     static void output_layout_add_handler(struct wl_listener* listener, void* data);
+
+    /// Executed when outputs are added, removed or moved in \a output_layout, or change their size.
+    static void output_layout_change_handler(struct wl_listener* listener, void* data);
+
+    /// Executed when an output disabled by an output configuration client is destroyed.
+    static void disabled_output_destroy_handler(struct wl_listener* listener, void* data);
 };
 
 using OutputManagerInstance = std::unique_ptr<OutputManager>;
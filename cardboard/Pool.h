@@ -0,0 +1,129 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+Copyright (C) 2020 Alexandru-Iulian Magan, Tudor-Ioan Roman, and contributors.
+
+This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 3.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef CARDBOARD_POOL_H_INCLUDED
+#define CARDBOARD_POOL_H_INCLUDED
+
+#include <algorithm>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * \file
+ * \brief Fixed-size allocators for objects that are created and destroyed often.
+ */
+
+/**
+ * \brief Hands out memory slots of \a size bytes aligned to \a align, carved out of chunks
+ * of \a slots_per_chunk slots.
+ *
+ * Freed slots are kept in a free list and reused. Chunks are only released when the allocator is destroyed.
+ */
+template <std::size_t size, std::size_t align, std::size_t slots_per_chunk = 32>
+class SlabAllocator {
+public:
+    SlabAllocator() = default;
+    SlabAllocator(const SlabAllocator&) = delete;
+    SlabAllocator& operator=(const SlabAllocator&) = delete;
+    SlabAllocator(SlabAllocator&& other) noexcept
+        : free_list { std::exchange(other.free_list, nullptr) }
+        , chunks { std::exchange(other.chunks, {}) }
+    {
+    }
+
+    ~SlabAllocator()
+    {
+        for (auto* chunk : chunks) {
+            ::operator delete(chunk, std::align_val_t { alignof(Slot) });
+        }
+    }
+
+    void* allocate()
+    {
+        if (free_list == nullptr) {
+            grow();
+        }
+
+        Slot* slot = free_list;
+        free_list = slot->next_free;
+        return slot;
+    }
+
+    void deallocate(void* pointer)
+    {
+        auto* slot = static_cast<Slot*>(pointer);
+        slot->next_free = free_list;
+        free_list = slot;
+    }
+
+private:
+    union Slot {
+        Slot* next_free;
+        alignas(align) std::byte storage[size];
+    };
+
+    void grow()
+    {
+        auto* chunk = static_cast<Slot*>(::operator new(sizeof(Slot) * slots_per_chunk, std::align_val_t { alignof(Slot) }));
+        chunks.push_back(chunk);
+
+        for (std::size_t i = slots_per_chunk; i > 0; i--) {
+            deallocate(&chunk[i - 1]);
+        }
+    }
+
+    Slot* free_list = nullptr;
+    std::vector<Slot*> chunks;
+};
+
+/**
+ * \brief Allocates objects of a class hierarchy rooted in \a Base from a single SlabAllocator.
+ *
+ * Every slot is big enough to hold any of \a Types, so objects of different types share the same free list.
+ */
+template <typename Base, typename... Types>
+class ObjectPool {
+public:
+    template <typename T, typename... Args>
+    T* create(Args&&... args)
+    {
+        static_assert((std::is_same_v<T, Types> || ...), "the type is not managed by this pool");
+
+        void* slot = allocator.allocate();
+        try {
+            return new (slot) T(std::forward<Args>(args)...);
+        } catch (...) {
+            allocator.deallocate(slot);
+            throw;
+        }
+    }
+
+    /// Destroys \a object and gives its slot back to the pool.
+    void destroy(Base* object)
+    {
+        void* slot;
+        if constexpr (std::is_polymorphic_v<Base>) {
+            slot = dynamic_cast<void*>(object);
+        } else {
+            slot = object;
+        }
+
+        object->~Base();
+        allocator.deallocate(slot);
+    }
+
+private:
+    SlabAllocator<std::max({ sizeof(Types)... }), std::max({ alignof(Types)... })> allocator;
+};
+
+#endif // CARDBOARD_POOL_H_INCLUDED
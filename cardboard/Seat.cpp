@@ -30,7 +30,7 @@ extern "C" {
 
 static void add_keyboard(Server& server, Seat& seat, struct wlr_input_device* device)
 {
-    seat.keyboards.push_back(Keyboard { device });
+    seat.keyboards.push_back(Keyboard { device, std::nullopt });
     auto& keyboard = seat.keyboards.back();
     keyboard.device->data = &keyboard;
 
@@ -81,7 +81,10 @@ void init_seat(Server& server, Seat& seat, const char* name)
     seat.wlr_seat->data = &seat;
 
     seat.cursor = SeatCursor {};
-    init_cursor(*(server.output_manager), seat.cursor);
+    {
+        auto phase = server.startup_trace.phase("init_cursor");
+        init_cursor(server, seat.cursor);
+    }
 
     seat.inhibit_manager = wlr_input_inhibit_manager_create(server.wl_display);
 
@@ -90,11 +93,11 @@ void init_seat(Server& server, Seat& seat, const char* name)
                                          { &seat.wlr_seat->events.request_set_selection, Seat::request_selection_handler },
                                          { &seat.wlr_seat->events.request_set_primary_selection, Seat::request_primary_selection_handler },
 
-                                         { &seat.cursor.wlr_cursor->events.motion, Seat::cursor_motion_handler },
-                                         { &seat.cursor.wlr_cursor->events.motion_absolute, Seat::cursor_motion_absolute_handler },
-                                         { &seat.cursor.wlr_cursor->events.button, Seat::cursor_button_handler },
-                                         { &seat.cursor.wlr_cursor->events.axis, Seat::cursor_axis_handler },
-                                         { &seat.cursor.wlr_cursor->events.frame, Seat::cursor_frame_handler },
+                                         { &seat.cursor.wlr_cursor->events.motion, TypedListener<Seat, &Seat::cursor_motion_handler>::notify },
+                                         { &seat.cursor.wlr_cursor->events.motion_absolute, TypedListener<Seat, &Seat::cursor_motion_absolute_handler>::notify },
+                                         { &seat.cursor.wlr_cursor->events.button, TypedListener<Seat, &Seat::cursor_button_handler>::notify },
+                                         { &seat.cursor.wlr_cursor->events.axis, TypedListener<Seat, &Seat::cursor_axis_handler>::notify },
+                                         { &seat.cursor.wlr_cursor->events.frame, TypedListener<Seat, &Seat::cursor_frame_handler>::notify },
 
                                          { &seat.cursor.wlr_cursor->events.swipe_begin, Seat::cursor_swipe_begin_handler },
                                          { &seat.cursor.wlr_cursor->events.swipe_update, Seat::cursor_swipe_update_handler },
@@ -183,6 +186,7 @@ void Seat::focus_view(Server& server, OptionalRef<View> view, bool condense_work
     // if the view is null, then focus_view will only
     // unfocus the previously focused one
     if (!view) {
+        publish_event(server, { .type = libcardboard::events::Type::ViewFocused });
         return;
     }
 
@@ -199,12 +203,16 @@ void Seat::focus_view(Server& server, OptionalRef<View> view, bool condense_work
             focus_stack.push_front(&view_r);
         }
 
-        // move the view_r to the front
-        server.surface_manager.move_view_to_front(view_r);
+        // floating views are raised to the top of their workspace
+        if (view_r.workspace_id >= 0) {
+            server.output_manager->get_view_workspace(view_r).raise_floating_view(view_r);
+        }
         // activate surface
         view_r.set_activated(true);
         // the seat will send keyboard events to the view automatically
         keyboard_notify_enter(view_r.get_surface());
+
+        publish_event(server, { .type = libcardboard::events::Type::ViewFocused, .workspace = static_cast<int32_t>(view_r.workspace_id), .view = view_r.id });
     }
 
 fit_on_screen:
@@ -260,8 +268,7 @@ void Seat::begin_move(Server& server, View& view)
     }
 
     auto& workspace = server.output_manager->get_view_workspace(view);
-    auto floating_it = std::find(workspace.floating_views.begin(), workspace.floating_views.end(), &view);
-    bool is_tiled = floating_it == workspace.floating_views.end();
+    bool is_tiled = !workspace.is_view_floating(view);
 
     if (is_tiled) {
         for (auto& column : workspace.columns) {
@@ -292,8 +299,7 @@ void Seat::begin_resize(Server& server, View& view, uint32_t edges)
     }
 
     auto& workspace = server.output_manager->get_view_workspace(view);
-    auto floating_it = std::find(workspace.floating_views.begin(), workspace.floating_views.end(), &view);
-    bool is_tiled = floating_it == workspace.floating_views.end();
+    bool is_tiled = !workspace.is_view_floating(view);
 
     if (is_tiled) {
         for (auto& column : workspace.columns) {
@@ -571,13 +577,9 @@ bool Seat::is_grabbing(View& view)
 
 OptionalRef<Workspace> Seat::get_focused_workspace(Server& server)
 {
-    for (auto& ws : server.output_manager->workspaces) {
-        if (ws.output && server.output_manager->output_contains_point(ws.output.unwrap(), cursor.wlr_cursor->x, cursor.wlr_cursor->y)) {
-            return ws;
-        }
-    }
-
-    return OptionalRef<Workspace>(nullptr);
+    return server.output_manager->get_output_at(cursor.wlr_cursor->x, cursor.wlr_cursor->y).and_then<Workspace>([](auto& output) {
+        return output.workspace;
+    });
 }
 
 void Seat::keyboard_notify_enter(struct wlr_surface* surface)
@@ -643,6 +645,12 @@ void Seat::focus(Server& server, Workspace& workspace)
         return;
     }
 
+    {
+        // an inactive workspace is shown on the output of the focused workspace
+        OptionalRef<Output> output = workspace.output ? workspace.output : get_focused_workspace(server).and_then<Output>([](auto& ws) { return ws.output; });
+        publish_event(server, { .type = libcardboard::events::Type::WorkspaceFocused, .workspace = static_cast<int32_t>(workspace.index), .output = output ? output.unwrap().wlr_output->name : "" });
+    }
+
     if (!workspace.output.has_value()) {
         bool do_return = true;
         Workspace& previous_workspace = get_focused_workspace(server).unwrap();
@@ -675,10 +683,10 @@ void Seat::focus(Server& server, Workspace& workspace)
         }
 
         for (auto& floating_view : previous_workspace.floating_views) {
-            floating_view.get()->y += height_offset;
-            animation_tasks.push_back({ floating_view.get(),
-                                        floating_view.get()->x,
-                                        floating_view.get()->y - height_offset });
+            floating_view.y += height_offset;
+            animation_tasks.push_back({ &floating_view,
+                                        floating_view.x,
+                                        floating_view.y - height_offset });
         }
 
         if (animation_tasks.size() > 0) {
@@ -724,9 +732,9 @@ void Seat::focus(Server& server, Workspace& workspace)
         }
 
         for (auto& floating_view : previous_workspace.floating_views) {
-            animation_tasks.push_back({ floating_view.get(),
-                                        floating_view.get()->x,
-                                        floating_view.get()->y - height_offset });
+            animation_tasks.push_back({ &floating_view,
+                                        floating_view.x,
+                                        floating_view.y - height_offset });
         }
 
         if (animation_tasks.size() > 0) {
@@ -826,59 +834,55 @@ void Seat::request_primary_selection_handler(struct wl_listener* listener, void*
     wlr_seat_set_primary_selection(seat->wlr_seat, event->source, event->serial);
 }
 
-void Seat::cursor_motion_handler(struct wl_listener* listener, void* data)
+void Seat::cursor_motion_handler(Server& server, void* data)
 {
-    auto* server = get_server(listener);
-    auto* seat = get_listener_data<Seat*>(listener);
     auto* event = static_cast<struct wlr_event_pointer_motion*>(data);
 
     // in case the user was doing a three finger swipe and lifted two fingers.
-    seat->end_touchpad_swipe(*server);
+    end_touchpad_swipe(server);
 
-    wlr_cursor_move(seat->cursor.wlr_cursor, event->device, event->delta_x, event->delta_y);
-    seat->process_cursor_motion(*server, event->time_msec);
+    wlr_cursor_move(cursor.wlr_cursor, event->device, event->delta_x, event->delta_y);
+    process_cursor_motion(server, event->time_msec);
 }
 
-void Seat::cursor_motion_absolute_handler(struct wl_listener* listener, void* data)
+void Seat::cursor_motion_absolute_handler(Server& server, void* data)
 {
-    auto* server = get_server(listener);
-    auto* seat = get_listener_data<Seat*>(listener);
     auto* event = static_cast<struct wlr_event_pointer_motion_absolute*>(data);
 
-    wlr_cursor_warp_absolute(seat->cursor.wlr_cursor, event->device, event->x, event->y);
-    seat->process_cursor_motion(*server, event->time_msec);
+    wlr_cursor_warp_absolute(cursor.wlr_cursor, event->device, event->x, event->y);
+    process_cursor_motion(server, event->time_msec);
 }
 
-void Seat::cursor_button_handler(struct wl_listener* listener, void* data)
+void Seat::cursor_button_handler(Server& server, void* data)
 {
-    auto* server = get_server(listener);
-    auto* seat = get_listener_data<Seat*>(listener);
     auto* event = static_cast<struct wlr_event_pointer_button*>(data);
 
     if (event->state == WLR_BUTTON_RELEASED) {
-        wlr_seat_pointer_notify_button(seat->wlr_seat, event->time_msec, event->button, event->state);
+        wlr_seat_pointer_notify_button(wlr_seat, event->time_msec, event->button, event->state);
         // end grabbing
-        seat->end_interactive(*server);
+        end_interactive(server);
         return;
     }
 
     double sx, sy;
     struct wlr_surface* surface;
-    auto view = server->surface_manager.get_surface_under_cursor(*(server->output_manager), seat->cursor.wlr_cursor->x, seat->cursor.wlr_cursor->y, surface, sx, sy);
+    auto view = server.surface_manager.get_surface_under_cursor(*server.output_manager, cursor.wlr_cursor->x, cursor.wlr_cursor->y, surface, sx, sy);
     if (!view) {
-        wlr_seat_pointer_notify_button(seat->wlr_seat, event->time_msec, event->button, event->state);
+        wlr_seat_pointer_notify_button(wlr_seat, event->time_msec, event->button, event->state);
         return;
     }
     auto& view_r = view.unwrap();
-    if (seat->is_mod_pressed(server->config.mouse_mods)) {
+    // the client may open a popup, placed from the position it knows
+    view_r.flush_position();
+    if (is_mod_pressed(server.config.mouse_mods)) {
         if (event->button == BTN_LEFT) {
-            cursor_set_image(*server, *seat, seat->cursor, "grab");
-            seat->begin_move(*server, view_r);
-            wlr_seat_pointer_clear_focus(seat->wlr_seat); // must be _after_ begin_move
+            cursor_set_image(server, *this, cursor, "grab");
+            begin_move(server, view_r);
+            wlr_seat_pointer_clear_focus(wlr_seat); // must be _after_ begin_move
         } else if (event->button == BTN_RIGHT) {
             uint32_t edge = 0;
-            edge |= seat->cursor.wlr_cursor->x > view_r.x + view_r.geometry.x + view_r.geometry.width / 2 ? WLR_EDGE_RIGHT : WLR_EDGE_LEFT;
-            edge |= seat->cursor.wlr_cursor->y > view_r.y + view_r.geometry.y + view_r.geometry.height / 2 ? WLR_EDGE_BOTTOM : WLR_EDGE_TOP;
+            edge |= cursor.wlr_cursor->x > view_r.x + view_r.geometry.x + view_r.geometry.width / 2 ? WLR_EDGE_RIGHT : WLR_EDGE_LEFT;
+            edge |= cursor.wlr_cursor->y > view_r.y + view_r.geometry.y + view_r.geometry.height / 2 ? WLR_EDGE_BOTTOM : WLR_EDGE_TOP;
             const char* image = NULL;
             if (edge == (WLR_EDGE_LEFT | WLR_EDGE_TOP)) {
                 image = "nw-resize";
@@ -890,35 +894,31 @@ void Seat::cursor_button_handler(struct wl_listener* listener, void* data)
                 image = "sw-resize";
             }
 
-            cursor_set_image(*server, *seat, seat->cursor, image);
-            seat->begin_resize(*server, view_r, edge);
-            wlr_seat_pointer_clear_focus(seat->wlr_seat); // must be _after_ begin_resize
+            cursor_set_image(server, *this, cursor, image);
+            begin_resize(server, view_r, edge);
+            wlr_seat_pointer_clear_focus(wlr_seat); // must be _after_ begin_resize
         }
     } else {
-        wlr_seat_pointer_notify_button(seat->wlr_seat, event->time_msec, event->button, event->state);
-        if (view != seat->get_focused_view()) {
-            seat->focus_view(*server, view);
+        wlr_seat_pointer_notify_button(wlr_seat, event->time_msec, event->button, event->state);
+        if (view != get_focused_view()) {
+            focus_view(server, view);
         }
     }
 }
 
-void Seat::cursor_axis_handler(struct wl_listener* listener, void* data)
+void Seat::cursor_axis_handler(Server& server, void* data)
 {
-    auto* server = get_server(listener);
-    auto* seat = get_listener_data<Seat*>(listener);
     auto* event = static_cast<struct wlr_event_pointer_axis*>(data);
 
     // in case the user was doing a three finger swipe and lifted a finger
-    seat->end_touchpad_swipe(*server);
+    end_touchpad_swipe(server);
 
-    wlr_seat_pointer_notify_axis(seat->wlr_seat, event->time_msec, event->orientation, event->delta, event->delta_discrete, event->source);
+    wlr_seat_pointer_notify_axis(wlr_seat, event->time_msec, event->orientation, event->delta, event->delta_discrete, event->source);
 }
 
-void Seat::cursor_frame_handler(struct wl_listener* listener, void*)
+void Seat::cursor_frame_handler(Server&, void*)
 {
-    auto* seat = get_listener_data<Seat*>(listener);
-
-    wlr_seat_pointer_notify_frame(seat->wlr_seat);
+    wlr_seat_pointer_notify_frame(wlr_seat);
 }
 
 void Seat::cursor_swipe_begin_handler(struct wl_listener* listener, void* data)
@@ -180,14 +180,14 @@ public:
     *
     * \sa cursor_motion_absolute_handler for when the cursor "jumps".
     */
-    static void cursor_motion_handler(struct wl_listener* listener, void* data);
+    void cursor_motion_handler(Server& server, void* data);
 
     /**
     * \brief Called when the cursor "jumps" or "warps" to an absolute position on the screen.
     *
     * \sa cursor_motion_handler for cursor moves by a delta.
     */
-    static void cursor_motion_absolute_handler(struct wl_listener* listener, void* data);
+    void cursor_motion_absolute_handler(Server& server, void* data);
 
     /**
     * \brief Handles mouse button clicks.
@@ -196,12 +196,12 @@ public:
     * it also focuses the window under the cursor, with its side effects, such as auto-scrolling
     * the viewport of the Workspace the View under the cursor is in.
     */
-    static void cursor_button_handler(struct wl_listener* listener, void* data);
+    void cursor_button_handler(Server& server, void* data);
 
     /**
     * \brief Handles scrolling.
     */
-    static void cursor_axis_handler(struct wl_listener* listener, void* data);
+    void cursor_axis_handler(Server& server, void* data);
 
     /**
     * \brief Handles pointer frame events.
@@ -210,7 +210,7 @@ public:
     * For instance, two axis events may happend at the same time, in which case a frame event
     * won't be sent in between.
     */
-    static void cursor_frame_handler(struct wl_listener* listener, void* data);
+    void cursor_frame_handler(Server& server, void* data);
 
     /**
      * \brief Called when the user starts a swipe on the touchpad (more than one finger).
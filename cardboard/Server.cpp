@@ -33,22 +33,33 @@ extern "C" {
 #include <wlr_cpp_fixes/types/wlr_layer_shell_v1.h>
 
 #include <sys/socket.h>
+#include <unistd.h>
 
 #include <cassert>
+#include <cerrno>
+#include <cstring>
 
 #include "Helpers.h"
 #include "IPC.h"
 #include "Seat.h"
 #include "Server.h"
-#include "Spawn.h"
 
 bool Server::init()
 {
+    auto init_phase = startup_trace.phase("Server::init");
+
+    // fork the launcher while the process is still small
+    launcher.start();
+
     wl_display = wl_display_create();
-    // let wlroots select the required hardware abstractions
-    backend = wlr_backend_autocreate(wl_display, nullptr);
+    {
+        auto phase = startup_trace.phase("backend_create");
+        // let wlroots select the required hardware abstractions
+        backend = wlr_backend_autocreate(wl_display, nullptr);
+    }
 
     event_loop = wl_display_get_event_loop(wl_display);
+    launcher.register_handlers(event_loop);
 
     renderer = wlr_backend_get_renderer(backend);
     wlr_renderer_init_wl_display(renderer, wl_display);
@@ -56,7 +67,10 @@ bool Server::init()
     compositor = wlr_compositor_create(wl_display, renderer);
     wlr_data_device_manager_create(wl_display); // for clipboard managers
 
-    output_manager = create_output_manager(this);
+    {
+        auto phase = startup_trace.phase("create_output_manager");
+        output_manager = create_output_manager(this);
+    }
 
     // https://drewdevault.com/2018/07/29/Wayland-shells.html
     xdg_shell = wlr_xdg_shell_create(wl_display);
@@ -71,7 +85,11 @@ bool Server::init()
     wlr_gtk_primary_selection_device_manager_create(wl_display);
     wlr_primary_selection_v1_device_manager_create(wl_display);
 
-    init_seat(*this, seat, DEFAULT_SEAT);
+    {
+        auto phase = startup_trace.phase("init_seat");
+        init_seat(*this, seat, DEFAULT_SEAT);
+    }
+    keybindings_config.chord_timer = wl_event_loop_add_timer(event_loop, KeybindingsConfig::chord_timeout_handler, &keybindings_config);
 
     config = Config {
         .mouse_mods = WLR_MODIFIER_LOGO,
@@ -151,11 +169,13 @@ bool Server::load_settings()
 
     wlr_log(WLR_DEBUG, "Running config file %s", config_path.c_str());
 
-    auto error_code = spawn([&]() {
-        execle(config_path.c_str(), config_path.c_str(), nullptr, environ);
+    // checked here because the launcher reports exec errors asynchronously
+    if (access(config_path.c_str(), X_OK) == -1) {
+        wlr_log(WLR_ERROR, "Couldn't execute the config file: %s", strerror(errno));
+        return false;
+    }
 
-        return EXIT_FAILURE;
-    });
+    auto error_code = launcher.launch({ config_path });
     if (error_code.value() != 0) {
         wlr_log(WLR_ERROR, "Couldn't execute the config file: %s", error_code.message().c_str());
         return false;
@@ -167,7 +187,10 @@ bool Server::load_settings()
 bool Server::run()
 {
 #if HAVE_XWAYLAND
-    init_xwayland();
+    {
+        auto phase = startup_trace.phase("init_xwayland");
+        init_xwayland();
+    }
 #endif
     // add UNIX socket to the Wayland display
     const char* socket = wl_display_add_socket_auto(wl_display);
@@ -176,20 +199,47 @@ bool Server::run()
         return false;
     }
 
-    if (!wlr_backend_start(backend)) {
-        wlr_backend_destroy(backend);
-        wl_display_destroy(wl_display);
-        return false;
+    setenv("WAYLAND_DISPLAY", socket, true);
+
+    // The IPC socket and the config script don't need the backend, so they are set up before starting it:
+    // the script starts while the backend sets the outputs up, and its commands wait on the socket
+    // until the event loop runs.
+    if (auto path = layout_snapshot_path(); !path) {
+        wlr_log(WLR_INFO, "XDG_RUNTIME_DIR or WAYLAND_DISPLAY is not usable, the layout won't be saved or restored");
+    } else if (auto snapshot = read_layout_snapshot(*path)) {
+        // the snapshot is only for the next start
+        unlink(path->c_str());
+        layout_restore.load(*snapshot);
+        wlr_log(WLR_INFO, "Restoring the layout of %zu workspaces", snapshot->workspaces.size());
     }
 
-    setenv("WAYLAND_DISPLAY", socket, true);
+    {
+        auto phase = startup_trace.phase("init_ipc");
+        if (!init_ipc()) {
+            return false;
+        }
+    }
+    {
+        auto phase = startup_trace.phase("load_settings");
+        if (!load_settings()) {
+            return false;
+        }
+    }
 
-    if (!init_ipc() || !load_settings()) {
-        return false;
+    {
+        auto phase = startup_trace.phase("backend_start");
+        if (!wlr_backend_start(backend)) {
+            // the display is destroyed by Server::stop
+            wlr_backend_destroy(backend);
+            return false;
+        }
     }
 
+    cursor_finish_theme_load(*this, seat.cursor);
+
     view_animation = create_view_animation(this, { 17, 100 });
 
+    startup_trace.mark("event_loop");
     wlr_log(WLR_INFO, "Running Cardboard on WAYLAND_DISPLAY=%s", socket);
     wl_display_run(wl_display);
 
@@ -198,7 +248,20 @@ bool Server::run()
 
 void Server::stop()
 {
+    // saved here rather than in Server::teardown, which also runs in signal handlers
+    if (auto path = layout_snapshot_path(); path) {
+        if (auto snapshot = take_layout_snapshot(*this); !snapshot.workspaces.empty() && !write_layout_snapshot(snapshot, *path)) {
+            wlr_log(WLR_ERROR, "Couldn't save the layout to %s", path->c_str());
+        }
+    }
+
     ipc = nullptr; // release ipc system
+    launcher.stop();
+    cursor_stop_theme_loads(seat.cursor);
+    if (keybindings_config.chord_timer) {
+        wl_event_source_remove(keybindings_config.chord_timer);
+        keybindings_config.chord_timer = nullptr;
+    }
     wlr_log(WLR_INFO, "Shutting down Cardboard");
 #if HAVE_XWAYLAND
     wlr_xwayland_destroy(xwayland);
@@ -222,7 +285,7 @@ void Server::new_xdg_surface_handler(struct wl_listener* listener, void* data)
         return;
     }
 
-    create_view(*server, new XDGView(xdg_surface));
+    create_view(*server, server->surface_manager.view_pool.create<XDGView>(xdg_surface));
 }
 
 void Server::new_layer_surface_handler(struct wl_listener* listener, void* data)
@@ -243,7 +306,7 @@ void Server::new_layer_surface_handler(struct wl_listener* listener, void* data)
             layer_surface->client_pending.margin.left);
 
     OptionalRef<Output> output_to_assign;
-    if (layer_surface->output) {
+    if (layer_surface->output && layer_surface->output->data) {
         output_to_assign = OptionalRef(static_cast<Output*>(layer_surface->output->data));
     } else {
         // Assigns output of the focused workspace
@@ -277,6 +340,6 @@ void Server::new_xwayland_surface_handler(struct wl_listener* listener, void* da
     }
 
     wlr_log(WLR_DEBUG, "new xwayland surface title='%s' class='%s'", xsurface->title, xsurface->class_);
-    create_view(*server, new XwaylandView(server, xsurface));
+    create_view(*server, server->surface_manager.view_pool.create<XwaylandView>(server, xsurface));
 }
 #endif
@@ -42,6 +42,8 @@ extern "C" {
 #include "Config.h"
 #include "IPC.h"
 #include "Keyboard.h"
+#include "Launcher.h"
+#include "LayoutSnapshot.h"
 #include "Layers.h"
 #include "Listener.h"
 #include "NotNull.h"
@@ -49,6 +51,7 @@ extern "C" {
 #include "Output.h"
 #include "OutputManager.h"
 #include "Seat.h"
+#include "StartupTrace.h"
 #include "SurfaceManager.h"
 #include "View.h"
 #include "ViewAnimation.h"
@@ -83,6 +86,8 @@ struct Server {
     wl_event_source* ipc_event_source;
 
     std::string config_path;
+    /// Starts the programs of \c exec and the config script.
+    Launcher launcher;
 
     struct wlr_xdg_shell* xdg_shell;
     struct wlr_layer_shell_v1* layer_shell;
@@ -98,6 +103,10 @@ struct Server {
 
     Seat seat;
 
+    StartupTrace startup_trace;
+    /// The layout saved by the previous instance, restored while its views map again.
+    LayoutRestore layout_restore;
+
     int exit_code = EXIT_SUCCESS;
 
     Server() = default;
@@ -10,36 +10,40 @@ You should have received a copy of the GNU General Public License along with thi
 */
 #include "Spawn.h"
 
-template <typename... Args>
-static void ignore(Args&&...)
-{
-}
+#include <csignal>
+#include <spawn.h>
+#include <unistd.h>
 
-std::error_code spawn(std::function<int()> fn)
+std::error_code spawn(const std::vector<std::string>& argv)
 {
-    // credits: http://www.lubutu.com/code/spawning-in-unix
-    int fd[2];
-    if (pipe(fd) == -1) {
-        int err = errno;
-        return std::error_code(err, std::generic_category());
+    if (argv.empty()) {
+        return std::error_code(EINVAL, std::generic_category());
     }
-    if (fork() == 0) {
-        close(fd[0]);
-        fcntl(fd[1], F_SETFD, FD_CLOEXEC);
 
-        setsid();
-        int status = fn();
+    // built in the parent: the child shares our memory until it execs, so it must not allocate
+    std::vector<char*> raw_argv;
+    raw_argv.reserve(argv.size() + 1);
+    for (const auto& arg : argv) {
+        raw_argv.push_back(const_cast<char*>(arg.c_str()));
+    }
+    raw_argv.push_back(nullptr);
 
-        ignore(write(fd[1], &errno, sizeof(errno)));
-        exit(status);
+    posix_spawnattr_t attributes;
+    if (int err = posix_spawnattr_init(&attributes); err != 0) {
+        return std::error_code(err, std::generic_category());
     }
 
-    close(fd[1]);
+    // the compositor ignores SIGPIPE and handles SIGCHLD, the programs it starts should not inherit that
+    sigset_t default_signals, empty_mask;
+    sigfillset(&default_signals);
+    sigemptyset(&empty_mask);
+    posix_spawnattr_setsigdefault(&attributes, &default_signals);
+    posix_spawnattr_setsigmask(&attributes, &empty_mask);
+    posix_spawnattr_setflags(&attributes, POSIX_SPAWN_SETSID | POSIX_SPAWN_SETSIGDEF | POSIX_SPAWN_SETSIGMASK);
 
-    int code = 0;
-    if (!read(fd[0], &code, sizeof(code))) {
-        code = 0;
-    }
-    close(fd[0]);
-    return std::error_code(code, std::generic_category());
+    pid_t pid;
+    int err = posix_spawnp(&pid, raw_argv[0], nullptr, &attributes, raw_argv.data(), environ);
+    posix_spawnattr_destroy(&attributes);
+
+    return std::error_code(err, std::generic_category());
 }
@@ -11,11 +11,9 @@ You should have received a copy of the GNU General Public License along with thi
 #ifndef CARDBOARD_SPAWN_H_INCLUDED
 #define CARDBOARD_SPAWN_H_INCLUDED
 
-#include <functional>
+#include <string>
 #include <system_error>
-
-#include <fcntl.h>
-#include <unistd.h>
+#include <vector>
 
 /**
  * \file
@@ -24,14 +22,16 @@ You should have received a copy of the GNU General Public License along with thi
  */
 
 /**
- * \brief Executes the function \a fn in a new process, in background.
- * \a fn should call a function from the \c exec(3) family.
+ * \brief Executes the program \a argv[0] with the arguments \a argv, in a new session, in background.
  *
- * If any library call from \a fn encounters an error (especially the exec function),
- * it is caught by the parent and returned by this function.
+ * The program is searched in \c PATH if its name doesn't contain a slash. The process is created with
+ * \c posix_spawn, which doesn't copy the address space of the compositor like \c fork does: the compositor
+ * is only suspended until the child calls \c exec, so the cost doesn't grow with the memory of the compositor.
+ * Nothing runs in the child before \c exec, and the signal dispositions and mask of the compositor
+ * are reset to their defaults for the child.
  *
- * \returns The errno value if something failed, or 0 if successful.
+ * \returns The errno value if something failed, including \c exec itself, or 0 if successful.
  * */
-std::error_code spawn(std::function<int()> fn);
+std::error_code spawn(const std::vector<std::string>& argv);
 
 #endif // CARDBOARD_SPAWN_H_INCLUDED
@@ -0,0 +1,114 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+Copyright (C) 2020 Alexandru-Iulian Magan, Tudor-Ioan Roman, and contributors.
+
+This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 3.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+extern "C" {
+#include <wlr/util/log.h>
+}
+
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+
+#include "StartupTrace.h"
+
+int64_t monotonic_ns()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<int64_t>(now.tv_sec) * 1'000'000'000 + now.tv_nsec;
+}
+
+StartupTrace::Scope::Scope(StartupTrace& trace, std::size_t index)
+    : trace { trace }
+    , index { index }
+{
+}
+
+StartupTrace::Scope::~Scope()
+{
+    trace.phases[index].end_ns = monotonic_ns();
+}
+
+StartupTrace::Scope StartupTrace::phase(std::string name)
+{
+    int64_t now = monotonic_ns();
+    add(std::move(name), now, now);
+    return Scope { *this, phases.size() - 1 };
+}
+
+void StartupTrace::add(std::string name, int64_t start_ns, int64_t end_ns)
+{
+    if (phases.empty()) {
+        origin_ns = start_ns;
+    }
+    phases.push_back({ std::move(name), start_ns, end_ns });
+}
+
+void StartupTrace::mark(std::string name)
+{
+    int64_t now = monotonic_ns();
+    add(std::move(name), now, now);
+}
+
+void StartupTrace::record_first_frame()
+{
+    if (first_frame_rendered) {
+        return;
+    }
+    first_frame_rendered = true;
+
+    mark("first_frame");
+    wlr_log(WLR_INFO, "First frame rendered %.3f ms after startup", (phases.back().start_ns - origin_ns) / 1e6);
+
+    if (const char* path = getenv(STARTUP_TRACE_ENV); path != nullptr && !write_trace(path)) {
+        wlr_log(WLR_ERROR, "Couldn't write the startup trace to %s", path);
+    }
+}
+
+std::string StartupTrace::format() const
+{
+    std::string result;
+    char line[128];
+
+    std::snprintf(line, sizeof(line), "%-24s %12s %14s\n", "phase", "start (ms)", "duration (ms)");
+    result += line;
+    for (const auto& phase : phases) {
+        std::snprintf(line, sizeof(line), "%-24s %12.3f %14.3f\n", phase.name.c_str(), (phase.start_ns - origin_ns) / 1e6, (phase.end_ns - phase.start_ns) / 1e6);
+        result += line;
+    }
+
+    return result;
+}
+
+bool StartupTrace::write_trace(const char* path) const
+{
+    FILE* file = std::fopen(path, "w");
+    if (file == nullptr) {
+        return false;
+    }
+
+    // the names are plain identifiers, they don't need escaping
+    std::fputs("{\"traceEvents\":[", file);
+    for (std::size_t i = 0; i < phases.size(); i++) {
+        const auto& phase = phases[i];
+        bool instant = phase.start_ns == phase.end_ns;
+        std::fprintf(file,
+                     "%s\n{\"name\":\"%s\",\"ph\":\"%s\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f%s}",
+                     i == 0 ? "" : ",",
+                     phase.name.c_str(),
+                     instant ? "i" : "X",
+                     (phase.start_ns - origin_ns) / 1e3,
+                     (phase.end_ns - phase.start_ns) / 1e3,
+                     instant ? ",\"s\":\"g\"" : "");
+    }
+    std::fputs("\n]}\n", file);
+
+    return std::fclose(file) == 0;
+}
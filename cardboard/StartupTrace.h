@@ -0,0 +1,75 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+Copyright (C) 2020 Alexandru-Iulian Magan, Tudor-Ioan Roman, and contributors.
+
+This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 3.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef CARDBOARD_STARTUP_TRACE_H_INCLUDED
+#define CARDBOARD_STARTUP_TRACE_H_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/// The environment variable naming the file where the startup trace is written.
+const char* const STARTUP_TRACE_ENV = "CARDBOARD_STARTUP_TRACE";
+
+/// Returns the \c CLOCK_MONOTONIC time in nanoseconds.
+int64_t monotonic_ns();
+
+/**
+ * \brief Timestamps of the startup phases of the compositor, up to the first rendered frame
+ *
+ * The phases are reported by <tt>cutter stats startup</tt>. If #STARTUP_TRACE_ENV is set, they are also
+ * written to that file in the Trace Event Format (viewable in Perfetto or \c chrome://tracing)
+ * when the first frame is rendered.
+ */
+struct StartupTrace {
+    struct Phase {
+        std::string name;
+        int64_t start_ns;
+        int64_t end_ns; ///< Equal to \c start_ns for instant marks.
+    };
+
+    /// Ends its phase when it goes out of scope.
+    class Scope {
+    public:
+        Scope(StartupTrace& trace, std::size_t index);
+        Scope(const Scope&) = delete;
+        ~Scope();
+
+    private:
+        StartupTrace& trace;
+        std::size_t index;
+    };
+
+    /// Time of the first phase, the origin of the reported times.
+    int64_t origin_ns = 0;
+    std::vector<Phase> phases;
+    bool first_frame_rendered = false;
+
+    /// Begins a phase named \a name, ended by the destruction of the returned scope.
+    [[nodiscard]] Scope phase(std::string name);
+
+    /// Records a phase measured elsewhere, for example on another thread.
+    void add(std::string name, int64_t start_ns, int64_t end_ns);
+
+    /// Records an instant mark.
+    void mark(std::string name);
+
+    /// Marks the first rendered frame, the end of the startup, and writes the trace file. Only the first call counts.
+    void record_first_frame();
+
+    /// Formats the phases as a table, with times in milliseconds since the origin.
+    std::string format() const;
+
+    /// Writes the phases to \a path in the Trace Event Format.
+    bool write_trace(const char* path) const;
+};
+
+#endif // CARDBOARD_STARTUP_TRACE_H_INCLUDED
@@ -0,0 +1,114 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+Copyright (C) 2020 Alexandru-Iulian Magan, Tudor-Ioan Roman, and contributors.
+
+This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 3.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+extern "C" {
+#include <wlr/types/wlr_output_layout.h>
+}
+
+#include "Output.h"
+#include "Server.h"
+#include "StateQuery.h"
+#include "View.h"
+
+namespace state = libcardboard::state;
+
+static state::View snapshot_view(View& view)
+{
+    return {
+        view.id,
+        { view.x, view.y, view.target_width, view.target_height },
+        view.expansion_state != View::ExpansionState::NORMAL,
+    };
+}
+
+static state::Workspace snapshot_workspace(Workspace& workspace)
+{
+    state::Workspace snapshot {
+        static_cast<int32_t>(workspace.index),
+        workspace.output ? workspace.output.unwrap().wlr_output->name : "",
+        workspace.scroll_x,
+        {},
+        {},
+    };
+
+    snapshot.columns.reserve(workspace.columns.size());
+    for (auto& column : workspace.columns) {
+        auto& column_snapshot = snapshot.columns.emplace_back();
+        column_snapshot.tiles.reserve(column.tiles.size());
+        for (auto& tile : column.tiles) {
+            column_snapshot.tiles.push_back(snapshot_view(*tile.view));
+        }
+    }
+
+    snapshot.floating_views.reserve(workspace.floating_views.size());
+    for (auto& floating_view : workspace.floating_views) {
+        snapshot.floating_views.push_back(snapshot_view(floating_view));
+    }
+
+    return snapshot;
+}
+
+state::Tree snapshot_tree(Server& server, uint64_t since)
+{
+    auto& output_manager = *server.output_manager;
+    auto focused_workspace = server.seat.get_focused_workspace(server);
+    auto focused_view = server.seat.get_focused_view();
+
+    state::Tree tree {
+        output_manager.generation,
+        since,
+        focused_workspace ? static_cast<int32_t>(focused_workspace.unwrap().index) : -1,
+        focused_view ? focused_view.unwrap().id : 0,
+        since == 0 || output_manager.outputs_generation > since,
+        {},
+        {},
+    };
+
+    if (tree.outputs_changed) {
+        tree.outputs = snapshot_outputs(server);
+    }
+
+    for (auto& workspace : output_manager.workspaces) {
+        if (since == 0 || workspace.generation > since) {
+            tree.workspaces.push_back(snapshot_workspace(workspace));
+        }
+    }
+
+    return tree;
+}
+
+std::vector<state::Workspace> snapshot_workspaces(Server& server)
+{
+    std::vector<state::Workspace> workspaces;
+
+    workspaces.reserve(server.output_manager->workspaces.size());
+    for (auto& workspace : server.output_manager->workspaces) {
+        workspaces.push_back(snapshot_workspace(workspace));
+    }
+
+    return workspaces;
+}
+
+std::vector<state::Output> snapshot_outputs(Server& server)
+{
+    std::vector<state::Output> outputs;
+
+    for (auto& output : server.output_manager->outputs) {
+        const auto* box = server.output_manager->get_output_box(output).get();
+        outputs.push_back({
+            output.wlr_output->name,
+            { box->x, box->y, box->width, box->height },
+            { output.usable_area.x, output.usable_area.y, output.usable_area.width, output.usable_area.height },
+            output.wlr_output->scale,
+        });
+    }
+
+    return outputs;
+}
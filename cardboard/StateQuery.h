@@ -0,0 +1,40 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+Copyright (C) 2020 Alexandru-Iulian Magan, Tudor-Ioan Roman, and contributors.
+
+This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 3.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef CARDBOARD_STATE_QUERY_H_INCLUDED
+#define CARDBOARD_STATE_QUERY_H_INCLUDED
+
+#include <cstdint>
+#include <vector>
+
+#include <cardboard/state_protocol.h>
+
+/**
+ * \file
+ * \brief Snapshots of the compositor state for the \c get_tree, \c get_workspaces and \c get_outputs commands.
+ */
+
+struct Server;
+
+/**
+ * \brief Takes a snapshot of the outputs and the workspaces.
+ *
+ * If \a since is not 0, only the workspaces changed after the generation \a since are included,
+ * and the outputs only if they changed after it.
+ */
+libcardboard::state::Tree snapshot_tree(Server& server, uint64_t since);
+
+/// Takes a snapshot of all the workspaces.
+std::vector<libcardboard::state::Workspace> snapshot_workspaces(Server& server);
+
+/// Takes a snapshot of all the outputs.
+std::vector<libcardboard::state::Output> snapshot_outputs(Server& server);
+
+#endif // CARDBOARD_STATE_QUERY_H_INCLUDED
@@ -18,15 +18,27 @@ void SurfaceManager::map_view(Server& server, View& view)
     // can be nullptr, this is fine
     auto* prev_focused = server.seat.get_focused_view().raw_pointer();
 
+    // after a restart, the view goes back where it was
+    if (auto restored_workspace = server.layout_restore.place(server, view)) {
+        publish_event(server, { .type = libcardboard::events::Type::ViewMapped, .workspace = static_cast<int32_t>(view.workspace_id), .view = view.id });
+        // don't steal the focus from the workspace the user is looking at
+        if (auto focused_workspace = server.seat.get_focused_workspace(server); focused_workspace && focused_workspace.unwrap().index == *restored_workspace) {
+            server.seat.focus_view(server, view);
+        }
+        return;
+    }
+
     server.seat.get_focused_workspace(server).and_then([&server, &view, prev_focused](auto& ws) {
         ws.add_view(*(server.output_manager), view, prev_focused);
     });
+    publish_event(server, { .type = libcardboard::events::Type::ViewMapped, .workspace = static_cast<int32_t>(view.workspace_id), .view = view.id });
     server.seat.focus_view(server, view);
 }
 
 void SurfaceManager::unmap_view(Server& server, View& view)
 {
     if (view.mapped) {
+        publish_event(server, { .type = libcardboard::events::Type::ViewUnmapped, .workspace = static_cast<int32_t>(view.workspace_id), .view = view.id });
         view.mapped = false;
         server.output_manager->get_view_workspace(view).remove_view(*(server.output_manager), view);
     }
@@ -35,39 +47,43 @@ void SurfaceManager::unmap_view(Server& server, View& view)
     server.seat.remove_from_focus_stack(view);
 }
 
-void SurfaceManager::move_view_to_front(View& view)
+void SurfaceManager::remove_view(ViewAnimation& view_animation, View& view)
 {
-    views.splice(views.begin(), views, std::find_if(views.begin(), views.end(), [&view](const std::unique_ptr<View>& x) { return &view == x.get(); }));
+    view_animation.cancel_tasks(view);
+    view_pool.destroy(&view);
 }
 
-void SurfaceManager::remove_view(ViewAnimation& view_animation, View& view)
+void SurfaceManager::update_xwayland_or_surface_outputs([[maybe_unused]] OutputManager& output_manager)
 {
-    view_animation.cancel_tasks(view);
-    views.remove_if([&view](const auto& other) { return &view == other.get(); });
+#if HAVE_XWAYLAND
+    for (auto& xwayland_or_surface : xwayland_or_surfaces) {
+        xwayland_or_surface->update_outputs(output_manager);
+    }
+#endif
 }
 
 OptionalRef<View> SurfaceManager::get_surface_under_cursor(OutputManager& output_manager, double lx, double ly, struct wlr_surface*& surface, double& sx, double& sy)
 {
     OptionalRef<Output> output = output_manager.get_output_at(lx, ly);
-    const auto ws_it = std::find_if(output_manager.workspaces.begin(), output_manager.workspaces.end(), [output](const auto& other) {
-        return other.output == output;
-    });
-    if (ws_it == output_manager.workspaces.end() || !ws_it->output) {
+    if (!output || !output.unwrap().workspace) {
         return NullRef<View>;
     }
+    auto* ws = output.unwrap().workspace.raw_pointer();
 
     // it is guaranteed that the workspace is activated on an output
 
     // we are trying surfaces from top to bottom
 
+    auto& layers = output.unwrap().layers;
+
     // first, overlays and top layers
     for (const auto layer : { ZWLR_LAYER_SHELL_V1_LAYER_OVERLAY, ZWLR_LAYER_SHELL_V1_LAYER_TOP }) {
         // fullscreen views render on top of the TOP layer
-        if (ws_it->fullscreen_view && layer == ZWLR_LAYER_SHELL_V1_LAYER_TOP) {
+        if (ws->fullscreen_view && layer == ZWLR_LAYER_SHELL_V1_LAYER_TOP) {
             continue;
         }
         for (const auto& layer_surface : layers[layer]) {
-            if (!layer_surface.surface->mapped || !layer_surface.is_on_output(ws_it->output.unwrap())) {
+            if (!layer_surface.surface->mapped) {
                 continue;
             }
 
@@ -79,33 +95,30 @@ OptionalRef<View> SurfaceManager::get_surface_under_cursor(OutputManager& output
 
     // second, unmanaged xwayland surfaces
 #if HAVE_XWAYLAND
-    for (const auto& xwayland_or_surface : xwayland_or_surfaces) {
-        if (!xwayland_or_surface->mapped) {
-            continue;
-        }
+    for (auto* xwayland_or_surface : output.unwrap().xwayland_or_surfaces) {
         if (xwayland_or_surface->get_surface_under_coords(lx, ly, surface, sx, sy)) {
             return NullRef<View>;
         }
     }
 #endif
 
-    if (ws_it->fullscreen_view && ws_it->fullscreen_view.unwrap().get_surface_under_coords(lx, ly, surface, sx, sy)) {
-        return ws_it->fullscreen_view;
+    if (ws->fullscreen_view && ws->fullscreen_view.unwrap().get_surface_under_coords(lx, ly, surface, sx, sy)) {
+        return ws->fullscreen_view;
     }
 
-    // third, floating views
-    for (NotNullPointer<View> floating_view : ws_it->floating_views) {
-        if (!floating_view->mapped) {
+    // third, floating views, from the top of the stack
+    for (auto& floating_view : ws->floating_views) {
+        if (!floating_view.mapped) {
             continue;
         }
 
-        if (floating_view->get_surface_under_coords(lx, ly, surface, sx, sy)) {
-            return OptionalRef(floating_view);
+        if (floating_view.get_surface_under_coords(lx, ly, surface, sx, sy)) {
+            return OptionalRef<View>(floating_view);
         }
     }
 
     // fourth, regular, tiled views
-    for (auto& column : ws_it->columns) {
+    for (auto& column : ws->columns) {
         for (auto& tile : column.tiles) {
             NotNullPointer<View> view = tile.view;
             if (!view->mapped) {
@@ -19,26 +19,42 @@ You should have received a copy of the GNU General Public License along with thi
 #include "Layers.h"
 #include "OptionalRef.h"
 #include "OutputManager.h"
+#include "Pool.h"
 #include "View.h"
 #include "ViewAnimation.h"
 #include "Workspace.h"
+#include "XDGView.h"
 #include "Xwayland.h"
 
+/// Pool from which all the views of the compositor are allocated, regardless of their underlying shell.
+#if HAVE_XWAYLAND
+using ViewPool = ObjectPool<View, XDGView, XwaylandView>;
+#else
+using ViewPool = ObjectPool<View, XDGView>;
+#endif
+
 struct SurfaceManager {
-    std::list<std::unique_ptr<View>> views;
+    ViewPool view_pool;
 #if HAVE_XWAYLAND
     std::list<std::unique_ptr<XwaylandORSurface>> xwayland_or_surfaces;
+    /// XwaylandORSurface::sequence of the next created override redirect surface.
+    uint64_t next_xwayland_or_sequence = 0;
 #endif
-    LayerArray layers;
+    /// Layer surfaces whose output was destroyed, kept until their clients destroy them. The others are in Output::layers.
+    std::list<LayerSurface> orphan_layers;
+    /// Id given to the next created view.
+    uint32_t next_view_id = 1;
 
     /// Common mapping procedure for views regardless of their underlying shell.
     void map_view(Server&, View&);
     /// Common unmapping procedure for views regardless of their underlying shell.
     void unmap_view(Server&, View&);
-    /// Puts the \a view on top.
-    void move_view_to_front(View&);
+    /// Unregisters the \a view and gives its memory back to the pool.
     void remove_view(ViewAnimation&, View&);
 
+    /// Puts the Xwayland override redirect surfaces again in the lists of the outputs they intersect, after the outputs changed.
+    void update_xwayland_or_surface_outputs(OutputManager&);
+
     /**
      * \brief Returns the xdg / xwayland / layer_shell surface leaf of the first
      * view / layer / xwayland override redirect surface under the cursor.
@@ -100,10 +100,9 @@ void View::resize(int width, int height)
     target_height = height;
 }
 
-void create_view(Server& server, NotNullPointer<View> view_)
+void create_view(Server& server, NotNullPointer<View> view)
 {
-    server.surface_manager.views.emplace_back(view_);
-    auto* view = server.surface_manager.views.back().get();
+    view->id = server.surface_manager.next_view_id++;
 
     view->prepare(server);
 }
@@ -18,10 +18,13 @@ extern "C" {
 #include <wlr/types/wlr_xdg_shell.h>
 }
 
+#include <cstdint>
 #include <list>
 #include <optional>
+#include <string>
 #include <utility>
 
+#include "IntrusiveList.h"
 #include "Workspace.h"
 
 struct Server;
@@ -91,6 +94,9 @@ public:
     /// Holds the size from when the view was tiled if it's currently floating, or from when the view was floating if currently tiled.
     std::pair<int, int> previous_size;
 
+    /// Unique id of the view, used to refer to it over IPC. Never 0.
+    uint32_t id;
+
     /// The id of the workspace this View is assigned to. Set to -1 if none.
     Workspace::IndexType workspace_id;
 
@@ -112,6 +118,9 @@ public:
     bool mapped;
     bool new_view; ///< True if the view didn't have its first map.
 
+    /// Links of this view in the Workspace::floating_views of its workspace, if it floats.
+    IntrusiveListHook<View> floating_link;
+
     /// Get the top level surface of this view.
     virtual struct wlr_surface* get_surface() = 0;
 
@@ -134,6 +143,9 @@ public:
     /// Requests the move to the client. Do not assume that the client is resized afterwards.
     virtual void move(OutputManager& server, int x, int y);
 
+    /// Sends the position to the client now, for shells that tell it lazily. Call before the client needs accurate coordinates.
+    virtual void flush_position() { }
+
     /// Prepares the view before registering to the server by attaching some handlers and doing shell-specific stuff.
     virtual void prepare(Server& server) = 0;
 
@@ -154,6 +166,12 @@ public:
     /// Closes view
     virtual void close() = 0;
 
+    /// Returns the application id (the class of X11 windows), or an empty string if it has none.
+    virtual std::string get_app_id() = 0;
+
+    /// Returns the title of the view, or an empty string if it has none.
+    virtual std::string get_title() = 0;
+
     /// Returns the output where this view is drawn on.
     OptionalRef<Output> get_views_output(Server& server);
 
@@ -176,6 +194,7 @@ protected:
     View()
         : geometry { 0, 0, 0, 0 }
         , expansion_state(ExpansionState::NORMAL)
+        , id(0)
         , workspace_id(-1)
         , x(0)
         , y(0)
@@ -187,7 +206,17 @@ protected:
     }
 };
 
-/// Registers a view to the server and attaches the event handlers.
+IntrusiveListHook<View>& FloatingViewHook::get(View& view)
+{
+    return view.floating_link;
+}
+
+const IntrusiveListHook<View>& FloatingViewHook::get(const View& view)
+{
+    return view.floating_link;
+}
+
+/// Registers a view to the server and attaches the event handlers. The \a view must be allocated from SurfaceManager::view_pool.
 void create_view(Server& server, NotNullPointer<View> view);
 
 #endif // CARDBOARD_VIEW_H_INCLUDED
@@ -74,6 +74,11 @@ int ViewAnimation::timer_callback(void* data)
         if (completeness < 0.999) { // animation incomplete;
             view_animation->tasks.push_back(task);
         } else {
+            task.view->flush_position();
+            // the view reached its place, report it once instead of on every frame
+            if (task.view->workspace_id >= 0) {
+                view_animation->output_manager->mark_changed(view_animation->output_manager->workspaces[task.view->workspace_id]);
+            }
             if (task.animation_finished_callback) {
                 task.animation_finished_callback();
             }
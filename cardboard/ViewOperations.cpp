@@ -56,15 +56,11 @@ void change_view_workspace(Server& server, View& view, Workspace& new_workspace)
 /// If a floating view changed the output it appears on (for example by dragging), move it to that output's workspace.
 static void update_view_workspace(Server& server, View& view)
 {
-    if (server.output_manager->workspaces[view.workspace_id].find_floating(&view) != server.output_manager->workspaces[view.workspace_id].floating_views.end()) {
+    if (server.output_manager->workspaces[view.workspace_id].is_view_floating(view)) {
         OptionalRef<Output> current_output = server.output_manager->get_output_at(view.x, view.y);
 
-        if (current_output && current_output != server.output_manager->workspaces[view.workspace_id].output) {
-            auto workspace = std::find_if(server.output_manager->workspaces.begin(), server.output_manager->workspaces.end(), [current_output](auto& w) {
-                return w.output == current_output;
-            });
-
-            change_view_workspace(server, view, *workspace);
+        if (current_output && current_output != server.output_manager->workspaces[view.workspace_id].output && current_output.unwrap().workspace) {
+            change_view_workspace(server, view, current_output.unwrap().workspace.unwrap());
         }
     }
 }
@@ -79,6 +75,7 @@ void reconfigure_view_position(Server& server, View& view, int x, int y, bool an
     } else {
         view.move(*server.output_manager, x, y);
         update_view_workspace(server, view);
+        server.output_manager->mark_changed(server.output_manager->get_view_workspace(view));
     }
 }
 
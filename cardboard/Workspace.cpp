@@ -82,29 +82,16 @@ std::list<Workspace::Column>::iterator Workspace::find_column(View* view)
     });
 }
 
-std::list<NotNullPointer<View>>::iterator Workspace::find_floating(View* view)
-{
-    // view can be null. if that's the case, this function will return floating_views.end()
-
-    // this if is not needed but it might be a slight optimisation
-    if (view == nullptr) {
-        return floating_views.end();
-    }
-
-    return std::find_if(floating_views.begin(), floating_views.end(), [view](const auto& v) {
-        return v == view;
-    });
-}
-
 void Workspace::add_view(OutputManager& output_manager, View& view, View* next_to, bool floating, bool transferring)
 {
-    // if next_to is null, view will be added at the end of the list
+    // if next_to is null, view will be added at the end of the columns, or on top of the floating views
     if (floating) {
-        auto it = find_floating(next_to);
-
-        floating_views.insert(
-            it == floating_views.end() ? it : ++it,
-            &view);
+        // floating views are stacked right below next_to, or on top of everything else
+        if (next_to && is_view_floating(*next_to)) {
+            floating_views.insert_after(*next_to, view);
+        } else {
+            floating_views.push_front(view);
+        }
     } else {
         auto it = find_column(next_to);
         if (it != columns.end()) {
@@ -145,7 +132,9 @@ void Workspace::remove_view(OutputManager& output_manager, View& view, bool tran
             columns.erase(column_it);
         }
     }
-    floating_views.remove(&view);
+    if (is_view_floating(view)) {
+        floating_views.remove(view);
+    }
 
     arrange_workspace(output_manager);
 }
@@ -183,6 +172,13 @@ void Workspace::pop_from_column(OutputManager& output_manager, Column& column)
 
 void Workspace::arrange_workspace(OutputManager& output_manager, bool animate)
 {
+    // a deferred arrangement marks the workspace changed when the transaction closes
+    if (output && output_manager.defer_arrangement(*this, animate)) {
+        return;
+    }
+
+    output_manager.mark_changed(*this);
+
     if (!output) {
         return;
     }
@@ -398,7 +394,15 @@ void Workspace::set_fullscreen_view(OutputManager& output_manager, OptionalRef<V
 
 bool Workspace::is_view_floating(View& view)
 {
-    return std::find(floating_views.begin(), floating_views.end(), &view) != floating_views.end();
+    // all workspaces share View::floating_link, so the list alone can't tell them apart
+    return view.workspace_id == index && floating_views.contains(view);
+}
+
+void Workspace::raise_floating_view(View& view)
+{
+    if (is_view_floating(view)) {
+        floating_views.move_to_front(view);
+    }
 }
 
 void Workspace::activate(Output& new_output)
@@ -410,10 +414,23 @@ void Workspace::activate(Output& new_output)
     }
 
     for (auto& floating_view : floating_views) {
-        floating_view->change_output(output, new_output);
+        floating_view.change_output(output, new_output);
     }
 
+    if (output && output.unwrap().workspace.raw_pointer() == this) {
+        output.unwrap().workspace = NullRef<Workspace>;
+    }
+    if (output) {
+        auto& outgoing = output.unwrap().outgoing_workspaces;
+        outgoing.erase(std::remove(outgoing.begin(), outgoing.end(), this), outgoing.end());
+    }
+    // the workspace shown until now stays visible until it is deactivated
+    if (new_output.workspace && new_output.workspace.raw_pointer() != this) {
+        new_output.outgoing_workspaces.push_back(new_output.workspace.raw_pointer());
+    }
     output = OptionalRef<Output>(new_output);
+    new_output.workspace = OptionalRef<Workspace>(*this);
+    server->output_manager->mark_changed(*this);
 }
 
 void Workspace::deactivate()
@@ -429,8 +446,14 @@ void Workspace::deactivate()
     }
 
     for (auto& floating_view : floating_views) {
-        floating_view->change_output(output.unwrap(), NullRef<Output>);
+        floating_view.change_output(output.unwrap(), NullRef<Output>);
     }
 
+    if (output.unwrap().workspace.raw_pointer() == this) {
+        output.unwrap().workspace = NullRef<Workspace>;
+    }
+    auto& outgoing = output.unwrap().outgoing_workspaces;
+    outgoing.erase(std::remove(outgoing.begin(), outgoing.end(), this), outgoing.end());
     output = NullRef<Output>;
+    server->output_manager->mark_changed(*this);
 }
@@ -17,11 +17,13 @@ extern "C" {
 }
 
 #include <algorithm>
+#include <cstdint>
 #include <list>
 #include <optional>
 #include <unordered_set>
 #include <vector>
 
+#include "IntrusiveList.h"
 #include "NotNull.h"
 #include "OptionalRef.h"
 
@@ -31,6 +33,12 @@ struct Output;
 struct OutputManager;
 struct Seat;
 
+/// Finds View::floating_link. Defined in View.h, as View is incomplete here.
+struct FloatingViewHook {
+    static inline IntrusiveListHook<View>& get(View& view);
+    static inline const IntrusiveListHook<View>& get(const View& view);
+};
+
 /**
  * \brief A Workspace is a group of tiled windows.
  *
@@ -98,7 +106,8 @@ struct Workspace {
     };
 
     std::list<Column> columns;
-    std::list<NotNullPointer<View>> floating_views;
+    /// The floating views of this workspace in stacking order, from top-most to bottom-most.
+    IntrusiveList<View, FloatingViewHook> floating_views;
 
     /**
      * \brief The output assigned to this workspace (or the output to which this workspace is assigned).
@@ -113,6 +122,9 @@ struct Workspace {
 
     IndexType index;
 
+    /// The OutputManager::generation of the last change of this workspace.
+    uint64_t generation = 0;
+
     /**
      * \brief The offset of the viewport.
      */
@@ -128,13 +140,6 @@ struct Workspace {
      */
     std::list<Column>::iterator find_column(View* view);
 
-    /**
-     * \brief Returns an iterator to the a floating view.
-     *
-     * \param view - can be null!
-     */
-    std::list<NotNullPointer<View>>::iterator find_floating(View* view);
-
     /**
     * \brief Adds the \a view to the right of the \a next_to view and tiles it accordingly.
     *
@@ -201,6 +206,9 @@ struct Workspace {
     /// Returns true if the view is floating in this Workspace.
     bool is_view_floating(View& view);
 
+    /// Moves the floating \a view to the top of floating_views. Does nothing if the view is tiled.
+    void raise_floating_view(View& view);
+
     /**
      * \brief Assigns the workspace to an \a output.
      */
@@ -125,6 +125,18 @@ void XDGView::close()
     wlr_xdg_toplevel_send_close(xdg_surface);
 }
 
+std::string XDGView::get_app_id()
+{
+    const char* app_id = xdg_surface->toplevel->app_id;
+    return app_id != nullptr ? app_id : "";
+}
+
+std::string XDGView::get_title()
+{
+    const char* title = xdg_surface->toplevel->title;
+    return title != nullptr ? title : "";
+}
+
 XDGPopup::XDGPopup(struct wlr_xdg_popup* wlr_popup, NotNullPointer<XDGView> parent)
     : wlr_popup(wlr_popup)
     , parent(parent)
@@ -189,7 +201,7 @@ void XDGView::surface_map_handler(struct wl_listener* listener, void*)
         wl_signal* signal;
         wl_notify_func_t notify;
     } to_add_listeners[] = {
-        { &view->xdg_surface->surface->events.commit, XDGView::surface_commit_handler },
+        { &view->xdg_surface->surface->events.commit, TypedListener<XDGView, &XDGView::surface_commit_handler>::notify },
         { &view->xdg_surface->toplevel->events.request_move, XDGView::toplevel_request_move_handler },
         { &view->xdg_surface->toplevel->events.request_resize, XDGView::toplevel_request_resize_handler },
         { &view->xdg_surface->toplevel->events.request_fullscreen, XDGView::toplevel_request_fullscreen_handler },
@@ -228,23 +240,20 @@ void XDGView::surface_destroy_handler(struct wl_listener* listener, void*)
     server->surface_manager.remove_view(*server->view_animation, *view);
 }
 
-void XDGView::surface_commit_handler(struct wl_listener* listener, void*)
+void XDGView::surface_commit_handler(Server& server, void*)
 {
-    auto* view = get_listener_data<XDGView*>(listener);
-    auto* server = get_server(listener);
-
     struct wlr_box new_geo;
-    wlr_xdg_surface_get_geometry(view->xdg_surface, &new_geo);
-    auto& ws = server->output_manager->get_view_workspace(*view);
-    if (memcmp(&new_geo, &view->geometry, sizeof(struct wlr_box)) != 0) {
+    wlr_xdg_surface_get_geometry(xdg_surface, &new_geo);
+    auto& ws = server.output_manager->get_view_workspace(*this);
+    if (memcmp(&new_geo, &geometry, sizeof(struct wlr_box)) != 0) {
         // the view has set a new size
-        wlr_log(WLR_DEBUG, "new size (%3d %3d) -> (%3d %3d)", view->geometry.width, view->geometry.height, new_geo.width, new_geo.height);
-        view->geometry = new_geo;
-        view->recover();
+        wlr_log(WLR_DEBUG, "new size (%3d %3d) -> (%3d %3d)", geometry.width, geometry.height, new_geo.width, new_geo.height);
+        geometry = new_geo;
+        recover();
 
-        ws.arrange_workspace(*(server->output_manager));
+        ws.arrange_workspace(*server.output_manager);
     }
-    server->output_manager->set_dirty();
+    server.output_manager->set_dirty();
 }
 
 void XDGView::surface_new_popup_handler(struct wl_listener* listener, void* data)
@@ -34,6 +34,8 @@ public:
     bool is_transient_for(View& ancestor) final;
     void close_popups() final;
     void close() final;
+    std::string get_app_id() final;
+    std::string get_title() final;
 
 public:
     static void surface_map_handler(struct wl_listener* listener, void* data);
@@ -42,7 +44,7 @@ public:
     static void surface_new_popup_handler(struct wl_listener* listener, void* data);
 
 private:
-    static void surface_commit_handler(struct wl_listener* listener, void* data);
+    void surface_commit_handler(Server& server, void* data);
     static void toplevel_request_move_handler(struct wl_listener* listener, void* data);
     static void toplevel_request_resize_handler(struct wl_listener* listener, void* data);
     static void toplevel_request_fullscreen_handler(struct wl_listener* listener, void* data);
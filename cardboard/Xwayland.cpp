@@ -9,11 +9,15 @@ This program is distributed in the hope that it will be useful, but WITHOUT ANY
 You should have received a copy of the GNU General Public License along with this program. If not, see <https://www.gnu.org/licenses/>.
 */
 extern "C" {
+#include <wlr/types/wlr_output_layout.h>
 #include <wlr/util/log.h>
 }
 
+#include <algorithm>
+
 #include "Helpers.h"
 #include "Listener.h"
+#include "Output.h"
 #include "Server.h"
 #include "View.h"
 #include "Xwayland.h"
@@ -28,6 +32,10 @@ XwaylandView::XwaylandView(Server* server, struct wlr_xwayland_surface* xwayland
 
 void XwaylandView::destroy()
 {
+    if (configure_timer) {
+        wl_event_source_remove(configure_timer);
+        configure_timer = nullptr;
+    }
     server->listeners.clear_listeners(this);
     if (server->seat.is_grabbing(*this)) {
         server->seat.end_interactive(*server);
@@ -70,6 +78,9 @@ void XwaylandView::resize(int width, int height)
 
     View::resize(width, height);
 
+    // the configure carries the position too
+    configure_pending = false;
+    wl_event_source_timer_update(configure_timer, 0);
     wlr_xwayland_surface_configure(
         xwayland_surface, x, y, width, height);
 }
@@ -78,12 +89,40 @@ void XwaylandView::move(OutputManager& output_manager, int x_, int y_)
 {
     View::move(output_manager, x_, y_);
 
+    int64_t now = monotonic_ns();
+    if (!configure_pending) {
+        configure_pending = true;
+        configure_pending_since_ns = now;
+    }
+
+    if (now - configure_pending_since_ns >= MAX_CONFIGURE_DELAY_MS * 1'000'000) {
+        flush_position();
+    } else {
+        wl_event_source_timer_update(configure_timer, CONFIGURE_SETTLE_MS);
+    }
+}
+
+void XwaylandView::flush_position()
+{
+    if (!configure_pending) {
+        return;
+    }
+
+    configure_pending = false;
+    wl_event_source_timer_update(configure_timer, 0);
     wlr_xwayland_surface_configure(
         xwayland_surface, x, y, geometry.width, geometry.height);
 }
 
+int XwaylandView::configure_timer_handler(void* data)
+{
+    static_cast<XwaylandView*>(data)->flush_position();
+    return 0;
+}
+
 void XwaylandView::prepare(Server& server)
 {
+    configure_timer = wl_event_loop_add_timer(server.event_loop, XwaylandView::configure_timer_handler, this);
     register_handlers(server, this, {
                                         { &xwayland_surface->events.map, XwaylandView::surface_map_handler },
                                         { &xwayland_surface->events.unmap, XwaylandView::surface_unmap_handler },
@@ -94,6 +133,9 @@ void XwaylandView::prepare(Server& server)
 
 void XwaylandView::set_activated(bool activated)
 {
+    if (activated) {
+        flush_position();
+    }
     wlr_xwayland_surface_activate(xwayland_surface, activated);
     wlr_xwayland_set_seat(server->xwayland, server->seat.wlr_seat);
 }
@@ -136,6 +178,16 @@ void XwaylandView::close()
     wlr_xwayland_surface_close(xwayland_surface);
 }
 
+std::string XwaylandView::get_app_id()
+{
+    return xwayland_surface->class_ != nullptr ? xwayland_surface->class_ : "";
+}
+
+std::string XwaylandView::get_title()
+{
+    return xwayland_surface->title != nullptr ? xwayland_surface->title : "";
+}
+
 void XwaylandView::surface_map_handler(struct wl_listener* listener, void*)
 {
     auto* server = get_server(listener);
@@ -160,7 +212,7 @@ void XwaylandView::surface_map_handler(struct wl_listener* listener, void*)
 
     view->map_unmap_listeners[0] = server->listeners.add_listener(
         &view->xwayland_surface->surface->events.commit,
-        Listener { XwaylandView::surface_commit_handler, server, view });
+        Listener { TypedListener<XwaylandView, &XwaylandView::surface_commit_handler>::notify, server, view });
 
     view->map_unmap_listeners[1] = server->listeners.add_listener(
         &view->xwayland_surface->events.request_fullscreen,
@@ -205,27 +257,28 @@ void XwaylandView::surface_request_configure_handler(struct wl_listener* listene
     view->resize(view->geometry.width, view->geometry.height);
 }
 
-void XwaylandView::surface_commit_handler(struct wl_listener* listener, void*)
+void XwaylandView::surface_commit_handler(Server& server, void*)
 {
-    auto* server = get_server(listener);
-    auto* view = get_listener_data<XwaylandView*>(listener);
-
-    auto* xsurface = view->xwayland_surface;
+    auto* xsurface = xwayland_surface;
     // xwayland is weird
-    if (view->workspace_id < 0) {
+    if (workspace_id < 0) {
         return;
     }
-    auto& ws = server->output_manager->get_view_workspace(*view);
-    if (xsurface->x != view->x || xsurface->y != view->y || xsurface->width != view->geometry.width || xsurface->height != view->geometry.height) {
-        view->x = xsurface->x;
-        view->y = xsurface->y;
-        view->geometry.width = xsurface->width;
-        view->geometry.height = xsurface->height;
-        view->recover();
-
-        ws.arrange_workspace(*(server->output_manager));
+    auto& ws = server.output_manager->get_view_workspace(*this);
+    // while a move is throttled, the X server has a stale position and ours is the right one
+    bool position_changed = !configure_pending && (xsurface->x != x || xsurface->y != y);
+    if (position_changed || xsurface->width != geometry.width || xsurface->height != geometry.height) {
+        if (!configure_pending) {
+            x = xsurface->x;
+            y = xsurface->y;
+        }
+        geometry.width = xsurface->width;
+        geometry.height = xsurface->height;
+        recover();
+
+        ws.arrange_workspace(*server.output_manager);
     }
-    server->output_manager->set_dirty();
+    server.output_manager->set_dirty();
 }
 
 void XwaylandView::surface_request_fullscreen_handler(struct wl_listener* listener, void*)
@@ -263,10 +316,11 @@ void XwaylandORSurface::map(Server& server)
 {
     mapped = true;
     commit_listener = server.listeners.add_listener(&xwayland_surface->surface->events.commit,
-                                                    Listener { XwaylandORSurface::surface_commit_handler, &server, this });
+                                                    Listener { TypedListener<XwaylandORSurface, &XwaylandORSurface::surface_commit_handler>::notify, &server, this });
 
     lx = xwayland_surface->x;
     ly = xwayland_surface->y;
+    update_outputs(*server.output_manager);
 
     if (wlr_xwayland_or_surface_wants_focus(xwayland_surface)) {
         wlr_xwayland_set_seat(server.xwayland, server.seat.wlr_seat);
@@ -274,12 +328,43 @@ void XwaylandORSurface::map(Server& server)
     }
 }
 
+void XwaylandORSurface::update_outputs(OutputManager& output_manager)
+{
+    remove_from_outputs(output_manager);
+
+    output_box = { .x = lx, .y = ly, .width = xwayland_surface->width, .height = xwayland_surface->height };
+    if (!mapped) {
+        return;
+    }
+
+    for (auto& output : output_manager.outputs) {
+        if (!wlr_output_layout_intersects(output_manager.output_layout, output.wlr_output, &output_box)) {
+            continue;
+        }
+
+        auto& surfaces = output.xwayland_or_surfaces;
+        surfaces.insert(std::upper_bound(surfaces.begin(), surfaces.end(), this, [](const XwaylandORSurface* a, const XwaylandORSurface* b) {
+                            return a->sequence < b->sequence;
+                        }),
+                        this);
+    }
+}
+
+void XwaylandORSurface::remove_from_outputs(OutputManager& output_manager)
+{
+    for (auto& output : output_manager.outputs) {
+        auto& surfaces = output.xwayland_or_surfaces;
+        surfaces.erase(std::remove(surfaces.begin(), surfaces.end(), this), surfaces.end());
+    }
+}
+
 XwaylandORSurface* create_xwayland_or_surface(Server& server, struct wlr_xwayland_surface* xwayland_surface)
 {
     wlr_log(WLR_DEBUG, "new xwayland OR surface %d %d", xwayland_surface->x, xwayland_surface->y);
     auto* xwayland_or_surface = new XwaylandORSurface;
     xwayland_or_surface->server = &server;
     xwayland_or_surface->xwayland_surface = xwayland_surface;
+    xwayland_or_surface->sequence = server.surface_manager.next_xwayland_or_sequence++;
 
     register_handlers(server, xwayland_or_surface, { { &xwayland_or_surface->xwayland_surface->events.map, XwaylandORSurface::surface_map_handler }, { &xwayland_or_surface->xwayland_surface->events.unmap, XwaylandORSurface::surface_unmap_handler }, { &xwayland_or_surface->xwayland_surface->events.destroy, XwaylandORSurface::surface_destroy_handler }, { &xwayland_or_surface->xwayland_surface->events.request_configure, XwaylandORSurface::surface_request_configure_handler } });
 
@@ -300,6 +385,7 @@ void XwaylandORSurface::surface_unmap_handler(struct wl_listener* listener, void
     auto* xwayland_or_surface = get_listener_data<XwaylandORSurface*>(listener);
 
     xwayland_or_surface->mapped = false;
+    xwayland_or_surface->remove_from_outputs(*server->output_manager);
     server->listeners.remove_listener(xwayland_or_surface->commit_listener);
     if (server->seat.wlr_seat->keyboard_state.focused_surface == xwayland_or_surface->xwayland_surface->surface) {
         // restore focus to the last focused view
@@ -316,6 +402,7 @@ void XwaylandORSurface::surface_destroy_handler(struct wl_listener* listener, vo
     auto* xwayland_or_surface = get_listener_data<XwaylandORSurface*>(listener);
 
     server->listeners.clear_listeners(xwayland_or_surface);
+    xwayland_or_surface->remove_from_outputs(*server->output_manager);
     server->surface_manager.xwayland_or_surfaces.remove_if([xwayland_or_surface](const auto& x) { return xwayland_or_surface == x.get(); });
 }
 
@@ -327,13 +414,13 @@ void XwaylandORSurface::surface_request_configure_handler(struct wl_listener* li
     wlr_xwayland_surface_configure(xwayland_or_surface->xwayland_surface, ev->x, ev->y, ev->width, ev->height);
 }
 
-void XwaylandORSurface::surface_commit_handler(struct wl_listener* listener, void*)
+void XwaylandORSurface::surface_commit_handler(Server& server, void*)
 {
-    auto* server = get_server(listener);
-    auto* xwayland_or_surface = get_listener_data<XwaylandORSurface*>(listener);
-
-    xwayland_or_surface->lx = xwayland_or_surface->xwayland_surface->x;
-    xwayland_or_surface->ly = xwayland_or_surface->xwayland_surface->y;
+    lx = xwayland_surface->x;
+    ly = xwayland_surface->y;
+    if (lx != output_box.x || ly != output_box.y || xwayland_surface->width != output_box.width || xwayland_surface->height != output_box.height) {
+        update_outputs(*server.output_manager);
+    }
 
-    server->output_manager->set_dirty();
+    server.output_manager->set_dirty();
 }
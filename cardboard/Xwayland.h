@@ -19,8 +19,20 @@ extern "C" {
 
 #include <wlr_cpp_fixes/xwayland.h>
 
+/**
+ * \brief A managed X11 window.
+ *
+ * Moves during animations and scrolling are applied only on the compositor side, and the position is
+ * sent to the X server once the view settles, or at least every XwaylandView::MAX_CONFIGURE_DELAY_MS,
+ * so that clients don't get a ConfigureNotify and repaint on every frame.
+ */
 class XwaylandView final : public View {
 public:
+    /// Time without moves after which the position is sent to the X server.
+    static constexpr int CONFIGURE_SETTLE_MS = 100;
+    /// Maximum time the X server can be left with a stale position while the view keeps moving.
+    static constexpr int64_t MAX_CONFIGURE_DELAY_MS = 500;
+
     // This is pretty ugly, but remember that Xwayland by itself is ugly.
     // Views are supposed to not share state with the server, but X being X needs some info.
     Server* server;
@@ -28,6 +40,12 @@ public:
     struct wlr_xwayland_surface* xwayland_surface;
     /// Stores listeners that are active only when the view is mapped. They are removed when unmapping.
     std::array<struct wl_listener*, 2> map_unmap_listeners;
+    /// Fires when the view stopped moving, to send its position.
+    struct wl_event_source* configure_timer = nullptr;
+    /// True if the position known by the X server is stale.
+    bool configure_pending = false;
+    /// When the position became stale.
+    int64_t configure_pending_since_ns = 0;
 
     XwaylandView(Server* server, struct wlr_xwayland_surface* xwayland_surface);
     ~XwaylandView() = default;
@@ -36,6 +54,7 @@ public:
     bool get_surface_under_coords(double lx, double ly, struct wlr_surface*& surface, double& sx, double& sy) final;
     void resize(int width, int height) final;
     void move(OutputManager&, int x, int y) final;
+    void flush_position() final;
     void prepare(Server& server) final;
     void set_activated(bool activated) final;
     void set_fullscreen(bool fullscreen) final;
@@ -43,6 +62,8 @@ public:
     bool is_transient_for(View& ancestor) final;
     void close_popups() final;
     void close() final;
+    std::string get_app_id() final;
+    std::string get_title() final;
 
     void destroy();
     void unmap();
@@ -54,8 +75,9 @@ public:
     static void surface_request_configure_handler(struct wl_listener* listener, void* data);
 
 private:
-    static void surface_commit_handler(struct wl_listener* listener, void* data);
+    void surface_commit_handler(Server& server, void* data);
     static void surface_request_fullscreen_handler(struct wl_listener* listener, void* data);
+    static int configure_timer_handler(void* data);
 };
 
 /// An "unmanaged" Xwayland surface. The "OR" stands for Override Redirect. Stuff like menus and tooltips.
@@ -65,9 +87,17 @@ struct XwaylandORSurface {
     struct wl_listener* commit_listener;
     int lx, ly;
     bool mapped;
+    /// Creation order, which keeps the per-output lists (Output::xwayland_or_surfaces) sorted like SurfaceManager::xwayland_or_surfaces.
+    uint64_t sequence;
+    /// The box, in output layout coordinates, for which the surface was put in the per-output lists.
+    struct wlr_box output_box;
 
     bool get_surface_under_coords(double lx, double ly, struct wlr_surface*& surface, double& sx, double& sy);
     void map(Server& server);
+    /// Adds the surface to the lists of the outputs it intersects and removes it from the others.
+    void update_outputs(OutputManager& output_manager);
+    /// Removes the surface from the lists of all the outputs.
+    void remove_from_outputs(OutputManager& output_manager);
 
 public:
     static void surface_map_handler(struct wl_listener* listener, void* data);
@@ -76,7 +106,7 @@ public:
     static void surface_request_configure_handler(struct wl_listener* listener, void* data);
 
 private:
-    static void surface_commit_handler(struct wl_listener* listener, void* data);
+    void surface_commit_handler(Server& server, void* data);
 };
 
 /// Registers an XwaylandORSurface.
@@ -11,6 +11,10 @@ You should have received a copy of the GNU General Public License along with thi
 #ifndef CARDBOARD_COMMANDS_COMMANDS_H_INCLUDED
 #define CARDBOARD_COMMANDS_COMMANDS_H_INCLUDED
 
+extern "C" {
+#include <wlr/util/log.h>
+}
+
 #include <csignal>
 #include <cstdint>
 #include <locale>
@@ -20,11 +24,9 @@ You should have received a copy of the GNU General Public License along with thi
 #include "../Command.h"
 #include "../IPC.h"
 #include "../Server.h"
-#include "../Spawn.h"
+#include "../StateQuery.h"
 #include "../ViewOperations.h"
 
-extern char** environ;
-
 namespace commands {
 
 inline CommandResult config_mouse_mod(Server* server, uint32_t modifiers)
@@ -42,6 +44,17 @@ inline CommandResult config_gap(Server* server, int gap)
     return { "" };
 }
 
+inline CommandResult config_chord_timeout(Server* server, int milliseconds)
+{
+    using namespace std::string_literals;
+
+    if (milliseconds < 0) {
+        return { "Chord timeout must not be negative"s, false };
+    }
+    server->config.chord_timeout = milliseconds;
+    return { "" };
+}
+
 inline CommandResult config_focus_color(Server* server, float r, float g, float b, float a)
 {
     server->config.focus_color = { r, g, b, a };
@@ -54,14 +67,14 @@ inline CommandResult focus(Server* server, command_arguments::focus::Direction d
 
     auto focused_view_ = server->seat.get_focused_view();
     if (!focused_view_) {
-        return { "No focused view to use as reference"s };
+        return { "No focused view to use as reference"s, false };
     }
     auto& focused_view = focused_view_.unwrap();
     auto& workspace = server->output_manager->get_view_workspace(focused_view);
 
     auto column_it = workspace.find_column(&focused_view);
     if (column_it == workspace.columns.end()) {
-        return { "Focused view is floating"s };
+        return { "Focused view is floating"s, false };
     }
 
     if (direction == command_arguments::focus::Direction::Left || direction == command_arguments::focus::Direction::Right) {
@@ -115,30 +128,85 @@ inline CommandResult quit(Server* server, int code)
     return { "" };
 }
 
-inline CommandResult bind(Server* server, uint32_t modifiers, xkb_keysym_t sym, const Command& command)
+inline CommandResult bind(Server* server, const std::string& mode, const std::vector<KeyCombo>& sequence, const Command& command)
 {
-    server->keybindings_config.map[modifiers].insert({ sym, command });
+    using namespace std::string_literals;
+
+    if (!server->keybindings_config.bind(mode, sequence, command)) {
+        return { "Too many key bindings"s, false };
+    }
     return { "" };
 }
 
-inline CommandResult exec(Server*, std::vector<std::string> arguments)
+inline CommandResult get_tree(Server* server, uint64_t since, bool json)
 {
-    spawn([&arguments]() {
-        std::vector<char*> argv;
-        argv.reserve(arguments.size());
-        for (const auto& arg : arguments)
-            strcpy(
-                argv.emplace_back(static_cast<char*>(malloc(arg.size() + 1))),
-                arg.c_str());
-        argv.push_back(nullptr);
+    auto tree = snapshot_tree(*server, since);
+    return { json ? libcardboard::state::tree_to_json(tree) : libcardboard::state::write_tree(tree) };
+}
 
-        int err_code = execvpe(argv[0], argv.data(), environ);
+inline CommandResult get_workspaces(Server* server, bool json)
+{
+    auto workspaces = snapshot_workspaces(*server);
+    return { json ? libcardboard::state::workspaces_to_json(workspaces) : libcardboard::state::write_workspaces(workspaces) };
+}
 
-        for (auto p : argv)
-            free(p);
+inline CommandResult get_outputs(Server* server, bool json)
+{
+    auto outputs = snapshot_outputs(*server);
+    return { json ? libcardboard::state::outputs_to_json(outputs) : libcardboard::state::write_outputs(outputs) };
+}
 
-        return err_code;
-    });
+inline CommandResult batch(Server* server, const std::vector<Command>& commands)
+{
+    std::vector<BatchResult> results;
+    results.reserve(commands.size());
+    bool success = true;
+
+    server->output_manager->begin_layout_transaction();
+    for (const auto& command : commands) {
+        auto result = command(server);
+        success = success && result.success;
+        results.push_back({ result.success, std::move(result.message) });
+    }
+    server->output_manager->end_layout_transaction();
+
+    return { write_batch_results(results), success };
+}
+
+inline CommandResult noop(Server*)
+{
+    return { "" };
+}
+
+inline CommandResult echo(Server*, const std::string& payload)
+{
+    return { payload };
+}
+
+inline CommandResult stats(Server* server, command_arguments::stats::Kind kind)
+{
+    switch (kind) {
+    case command_arguments::stats::Kind::Startup:
+        return { server->startup_trace.format() };
+    }
+
+    return { "unknown statistics", false };
+}
+
+inline CommandResult mode(Server* server, const std::string& name)
+{
+    if (!server->keybindings_config.set_mode(name)) {
+        return { "No key bindings in mode " + name, false };
+    }
+    return { "" };
+}
+
+inline CommandResult exec(Server* server, std::vector<std::string> arguments)
+{
+    if (auto error_code = server->launcher.launch(arguments); error_code.value() != 0) {
+        wlr_log(WLR_ERROR, "Couldn't execute %s: %s", arguments.empty() ? "" : arguments[0].c_str(), error_code.message().c_str());
+        return { "Couldn't execute: " + error_code.message(), false };
+    }
 
     return { "" };
 }
@@ -157,7 +225,7 @@ inline CommandResult workspace_switch(Server* server, int n)
     using namespace std::string_literals;
 
     if (n < 0 or static_cast<size_t>(n) >= server->output_manager->workspaces.size())
-        return { "Invalid Workspace number" };
+        return { "Invalid Workspace number", false };
 
     server->seat.focus(*server, server->output_manager->workspaces[n]);
     server->output_manager->workspaces[n].arrange_workspace(*(server->output_manager));
@@ -169,11 +237,11 @@ inline CommandResult workspace_move(Server* server, int n)
     using namespace std::string_literals;
 
     if (n < 0 or static_cast<size_t>(n) >= server->output_manager->workspaces.size())
-        return { "Invalid Workspace number" };
+        return { "Invalid Workspace number", false };
 
     auto view = server->seat.get_focused_view();
     if (!view) {
-        return { "No view to move in current workspace"s };
+        return { "No view to move in current workspace"s, false };
     }
     change_view_workspace(*server, view.unwrap(), server->output_manager->workspaces[n]);
     server->output_manager->workspaces[n].arrange_workspace(*(server->output_manager));
@@ -218,7 +286,7 @@ inline CommandResult toggle_floating(Server* server)
     auto& view = view_.unwrap();
     auto& ws = server->output_manager->get_view_workspace(view);
 
-    bool currently_floating = server->output_manager->workspaces[view.workspace_id].find_floating(&view) != server->output_manager->workspaces[view.workspace_id].floating_views.end();
+    bool currently_floating = ws.is_view_floating(view);
 
     auto prev_size = view.previous_size;
 
@@ -316,7 +384,7 @@ inline CommandResult insert_into_column(Server* server)
 
     auto view = server->seat.get_focused_view();
     if (!view) {
-        return { "No view to move in current workspace"s };
+        return { "No view to move in current workspace"s, false };
     }
 
     auto& workspace = server->output_manager->get_view_workspace(view.unwrap());
@@ -341,17 +409,17 @@ inline CommandResult pop_from_column(Server* server)
 
     auto view = server->seat.get_focused_view();
     if (!view) {
-        return { "No view to move in current workspace"s };
+        return { "No view to move in current workspace"s, false };
     }
 
     if (view.unwrap().expansion_state != View::ExpansionState::NORMAL) {
-        return { "View must not be fullscreened"s };
+        return { "View must not be fullscreened"s, false };
     }
 
     auto& workspace = server->output_manager->get_view_workspace(view.unwrap());
     auto column_it = workspace.find_column(&view.unwrap());
     if (column_it == workspace.columns.end()) {
-        return { "View is floating"s };
+        return { "View is floating"s, false };
     }
 
     workspace.pop_from_column(*(server->output_manager), *column_it);
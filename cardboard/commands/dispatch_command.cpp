@@ -81,6 +81,11 @@ static Command dispatch_config(const command_arguments::config& config)
                               return [gap](Server* server) {
                                   return commands::config_gap(server, gap.gap);
                               };
+                          },
+                          [](command_arguments::config::chord_timeout chord_timeout) -> Command {
+                              return [chord_timeout](Server* server) {
+                                  return commands::config_chord_timeout(server, chord_timeout.milliseconds);
+                              };
                           } },
                       config.config);
 }
@@ -101,16 +106,23 @@ Command dispatch_command(const CommandData& command_data)
                               return [quit_data](Server* server) { return commands::quit(server, quit_data.code); };
                           },
                           [](const command_arguments::bind& bind_data) -> Command {
-                              uint32_t modifiers = modifier_array_to_mask(bind_data.modifiers);
+                              std::vector<KeyCombo> sequence;
+                              sequence.reserve(bind_data.sequence.size());
+                              for (const auto& key_combo : bind_data.sequence) {
+                                  uint32_t modifiers = modifier_array_to_mask(key_combo.modifiers);
+
+                                  xkb_keysym_t sym = xkb_keysym_from_name(key_combo.key.c_str(), XKB_KEYSYM_CASE_INSENSITIVE);
 
-                              xkb_keysym_t sym = xkb_keysym_from_name(bind_data.key.c_str(), XKB_KEYSYM_CASE_INSENSITIVE);
+                                  if (sym == XKB_KEY_NoSymbol)
+                                      return { [key = key_combo.key](Server*) -> CommandResult { return { std::string("Invalid keysym: ") + key, false }; } };
 
-                              if (sym == XKB_KEY_NoSymbol)
-                                  return { [bind_data](Server*) -> CommandResult { return { std::string("Invalid keysym: ") + bind_data.key }; } };
+                                  sequence.push_back({ modifiers, xkb_keysym_to_lower(sym) });
+                              }
 
+                              std::string mode = bind_data.mode.empty() ? std::string(KeybindingsConfig::DEFAULT_MODE) : bind_data.mode;
                               Command command = dispatch_command(*(bind_data.command));
-                              return { [modifiers, sym, command](Server* server) {
-                                  return commands::bind(server, modifiers, sym, command);
+                              return { [mode, sequence, command](Server* server) {
+                                  return commands::bind(server, mode, sequence, command);
                               } };
                           },
                           [](const command_arguments::exec exec_data) -> Command {
@@ -149,6 +161,56 @@ Command dispatch_command(const CommandData& command_data)
                           [](const command_arguments::cycle_width&) -> Command {
                               return commands::cycle_width;
                           },
+                          [](const command_arguments::mode& mode) -> Command {
+                              return [mode](Server* server) {
+                                  return commands::mode(server, mode.name);
+                              };
+                          },
+                          [](const command_arguments::batch& batch) -> Command {
+                              std::vector<Command> commands;
+                              commands.reserve(batch.commands.size());
+                              for (const auto& command_data : batch.commands) {
+                                  commands.push_back(dispatch_command(command_data));
+                              }
+
+                              return [commands = std::move(commands)](Server* server) {
+                                  return commands::batch(server, commands);
+                              };
+                          },
+                          [](const command_arguments::get_tree& get_tree) -> Command {
+                              return [get_tree](Server* server) {
+                                  return commands::get_tree(server, get_tree.since, get_tree.json);
+                              };
+                          },
+                          [](const command_arguments::get_workspaces& get_workspaces) -> Command {
+                              return [get_workspaces](Server* server) {
+                                  return commands::get_workspaces(server, get_workspaces.json);
+                              };
+                          },
+                          [](const command_arguments::get_outputs& get_outputs) -> Command {
+                              return [get_outputs](Server* server) {
+                                  return commands::get_outputs(server, get_outputs.json);
+                              };
+                          },
+                          [](const command_arguments::noop&) -> Command {
+                              return commands::noop;
+                          },
+                          [](const command_arguments::echo& echo) -> Command {
+                              return [echo](Server* server) {
+                                  return commands::echo(server, echo.payload);
+                              };
+                          },
+                          [](const command_arguments::stats& stats) -> Command {
+                              return [stats](Server* server) {
+                                  return commands::stats(server, stats.kind);
+                              };
+                          },
+                          [](const command_arguments::subscribe&) -> Command {
+                              // subscriptions are handled by the IPC connection that receives them
+                              return [](Server*) {
+                                  return CommandResult { "subscribe can't be used here", false };
+                              };
+                          },
                       },
                       command_data);
 }
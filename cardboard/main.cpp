@@ -12,8 +12,10 @@ extern "C" {
 #include <wlr/util/log.h>
 }
 
+#include <cstdlib>
+#include <cstring>
+
 #include <signal.h>
-#include <sys/wait.h>
 
 #include "BuildConfig.h"
 #include "Server.h"
@@ -22,23 +24,23 @@ Server server;
 
 void sig_handler(int signo)
 {
-    if (signo == SIGCHLD) {
-        signal(signo, sig_handler);
-        while (waitpid(-1, 0, WNOHANG) > 0)
-            ;
-    } else if (signo == SIGINT || signo == SIGHUP || signo == SIGTERM) {
+    if (signo == SIGINT || signo == SIGHUP || signo == SIGTERM) {
         server.teardown(0);
     }
 }
 
-int main()
+int main(int argc, char* argv[])
 {
+    if (argc == 3 && std::strcmp(argv[1], Launcher::LAUNCHER_HELPER_ARGUMENT) == 0) {
+        // re-executed by Launcher::start to replace a launcher that died
+        Launcher::run_helper(std::atoi(argv[2]));
+    }
+
     wlr_log_init(WLR_DEBUG, nullptr);
 
     signal(SIGINT, sig_handler);
     signal(SIGHUP, sig_handler);
     signal(SIGTERM, sig_handler);
-    signal(SIGCHLD, sig_handler);
     signal(SIGPIPE, SIG_IGN);
 
     if (!server.init()) {
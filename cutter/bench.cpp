@@ -0,0 +1,359 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+Copyright (C) 2020 Alexandru-Iulian Magan, Tudor-Ioan Roman, and contributors.
+
+This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 3.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <poll.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cardboard/async_client.h>
+#include <cardboard/command_protocol.h>
+#include <cardboard/ipc.h>
+
+#include "parse_arguments.h"
+
+using Clock = std::chrono::steady_clock;
+
+/// Commands sent when none are given on the command line: layout changes mixed with queries.
+static const char* DEFAULT_MIX[] = {
+    "focus left",
+    "focus right",
+    "move 10 0",
+    "move -10 0",
+    "resize 640 480",
+    "resize 800 600",
+    "workspace switch 1",
+    "workspace switch 0",
+    "get_workspaces",
+    "get_tree --since 1",
+    "noop",
+};
+
+/// How long to wait for a response before giving up.
+static constexpr int RESPONSE_TIMEOUT_MS = 10000;
+
+struct Options {
+    int connections = 4;
+    int commands = 10000; ///< Per connection.
+    int depth = 1; ///< Requests in flight per connection.
+    const char* headless_compositor = nullptr;
+    std::vector<std::string> mix;
+};
+
+/// A command of the mix, with the latencies of its responses in microseconds.
+struct MixEntry {
+    std::string text;
+    CommandData command_data;
+    std::vector<double> latencies;
+};
+
+struct Connection {
+    libcutter::AsyncClient client;
+    int remaining;
+    std::size_t next_command;
+};
+
+struct Bench {
+    std::vector<MixEntry> mix;
+    std::vector<Connection> connections;
+    int depth;
+    std::size_t completed = 0;
+    std::size_t failed = 0;
+    /// Why a command couldn't be queued, empty if all of them were. Reported by run.
+    std::string send_error;
+
+    /// Sends the next command of the mix on \a connection, if it has any left.
+    void send_next(Connection& connection)
+    {
+        if (connection.remaining == 0) {
+            return;
+        }
+        connection.remaining--;
+
+        auto& entry = mix[connection.next_command++ % mix.size()];
+        auto sent_at = Clock::now();
+        auto sent = connection.client.send_command(entry.command_data, [this, &connection, &entry, sent_at](tl::expected<std::string, int> response) {
+            if (response) {
+                entry.latencies.push_back(std::chrono::duration<double, std::micro>(Clock::now() - sent_at).count());
+                completed++;
+            } else {
+                failed++;
+            }
+            send_next(connection);
+        });
+        if (!sent) {
+            // nothing more can be sent on this connection
+            connection.remaining = 0;
+            if (send_error.empty()) {
+                send_error = sent.error();
+            }
+        }
+    }
+
+    /// Runs until every connection got all its responses. Returns false if the connections failed.
+    bool run()
+    {
+        for (auto& connection : connections) {
+            for (int i = 0; i < depth; i++) {
+                send_next(connection);
+            }
+        }
+
+        std::vector<struct pollfd> pollfds(connections.size());
+        while (true) {
+            if (!send_error.empty()) {
+                std::cerr << "cutter-bench: " << send_error << std::endl;
+                return false;
+            }
+
+            bool done = true;
+            for (std::size_t i = 0; i < connections.size(); i++) {
+                auto& client = connections[i].client;
+                done = done && client.pending_responses() == 0;
+                pollfds[i] = { client.fd(), client.poll_events(), 0 };
+            }
+            if (done) {
+                return true;
+            }
+
+            int ready = poll(pollfds.data(), pollfds.size(), RESPONSE_TIMEOUT_MS);
+            if (ready == -1 && errno == EINTR) {
+                continue;
+            }
+            if (ready <= 0) {
+                std::cerr << "cutter-bench: " << (ready == 0 ? "timed out waiting for responses" : std::strerror(errno)) << std::endl;
+                return false;
+            }
+
+            for (std::size_t i = 0; i < connections.size(); i++) {
+                if (pollfds[i].revents == 0) {
+                    continue;
+                }
+                if (int err = connections[i].client.dispatch(); err != 0) {
+                    std::cerr << "cutter-bench: connection " << i << ": " << std::strerror(err) << std::endl;
+                    return false;
+                }
+            }
+        }
+    }
+};
+
+/// Returns the \a p quantile of the sorted \a values.
+static double percentile(const std::vector<double>& values, double p)
+{
+    if (values.empty()) {
+        return 0;
+    }
+    auto index = static_cast<std::size_t>(p * (values.size() - 1) + 0.5);
+    return values[index];
+}
+
+static void print_latencies(const char* label, std::vector<double>& latencies)
+{
+    std::sort(latencies.begin(), latencies.end());
+    std::printf("%-24s %8zu %10.1f %10.1f %10.1f\n",
+                label,
+                latencies.size(),
+                percentile(latencies, 0.5),
+                percentile(latencies, 0.99),
+                latencies.empty() ? 0 : latencies.back());
+}
+
+/// Files of the compositor started by start_headless.
+struct HeadlessCompositor {
+    pid_t pid = -1;
+    std::string directory;
+
+    std::string config_directory() const { return directory + "/cardboard"; }
+    std::string config_path() const { return config_directory() + "/cardboardrc"; }
+    std::string socket_path() const { return directory + "/ipc"; }
+
+    ~HeadlessCompositor()
+    {
+        if (pid > 0) {
+            kill(pid, SIGTERM);
+            waitpid(pid, nullptr, 0);
+        }
+        if (!directory.empty()) {
+            unlink(socket_path().c_str());
+            unlink(config_path().c_str());
+            rmdir(config_directory().c_str());
+            rmdir(directory.c_str());
+        }
+    }
+};
+
+/**
+ * \brief Starts \a compositor on the headless backend, with one output and an empty config script
+ *
+ * The IPC socket is created in a temporary directory, and \c CARDBOARD_SOCKET is set to it
+ * so that the clients connect to this compositor.
+ */
+static bool start_headless(HeadlessCompositor& headless, const char* compositor)
+{
+    char directory[] = "/tmp/cutter-bench-XXXXXX";
+    if (mkdtemp(directory) == nullptr) {
+        std::cerr << "cutter-bench: mkdtemp: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    headless.directory = directory;
+
+    // an empty config, so that the user's bindings and autostarted programs don't interfere
+    mkdir(headless.config_directory().c_str(), 0700);
+    if (FILE* config = std::fopen(headless.config_path().c_str(), "w"); config != nullptr) {
+        std::fputs("#!/bin/sh\n", config);
+        std::fclose(config);
+        chmod(headless.config_path().c_str(), 0700);
+    } else {
+        std::cerr << "cutter-bench: couldn't write " << headless.config_path() << std::endl;
+        return false;
+    }
+
+    setenv(libcardboard::ipc::SOCKET_ENV_VAR, headless.socket_path().c_str(), true);
+
+    headless.pid = fork();
+    if (headless.pid == -1) {
+        std::cerr << "cutter-bench: fork: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    if (headless.pid == 0) {
+        setenv("WLR_BACKENDS", "headless", true);
+        setenv("WLR_HEADLESS_OUTPUTS", "1", true);
+        setenv("WLR_LIBINPUT_NO_DEVICES", "1", true);
+        setenv("XDG_CONFIG_HOME", headless.directory.c_str(), true);
+        execlp(compositor, compositor, nullptr);
+        _exit(127);
+    }
+
+    return true;
+}
+
+/// Connects to the compositor, waiting for a compositor started by start_headless to create its socket.
+static tl::expected<libcutter::AsyncClient, std::string> connect(const HeadlessCompositor& headless)
+{
+    using namespace std::chrono_literals;
+
+    for (auto waited = 0ms;; waited += 50ms) {
+        auto client = libcutter::open_async_client();
+        if (client || headless.pid <= 0 || waited >= 5s) {
+            return client;
+        }
+        if (waitpid(headless.pid, nullptr, WNOHANG) == headless.pid) {
+            return tl::unexpected(std::string("the compositor exited"));
+        }
+        std::this_thread::sleep_for(50ms);
+    }
+}
+
+static void print_usage(char* argv0)
+{
+    std::cerr << "Usage: " << argv0 << " [-c connections] [-n commands] [-d depth] [--headless [compositor]] [command...]" << std::endl;
+    std::cerr << std::endl;
+    std::cerr << "Sends each connection's commands round-robin from the given cutter commands (quoted, one per argument)," << std::endl;
+    std::cerr << "or from a default mix of focus, move, resize, workspace switch and query commands." << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    Options options;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        auto int_value = [&]() {
+            if (i + 1 >= argc || std::atoi(argv[i + 1]) <= 0) {
+                print_usage(argv[0]);
+                exit(EXIT_FAILURE);
+            }
+            return std::atoi(argv[++i]);
+        };
+
+        if (arg == "-c") {
+            options.connections = int_value();
+        } else if (arg == "-n") {
+            options.commands = int_value();
+        } else if (arg == "-d") {
+            options.depth = int_value();
+        } else if (arg == "--headless") {
+            options.headless_compositor = "cardboard";
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                options.headless_compositor = argv[++i];
+            }
+        } else if (arg == "-h" || arg == "--help") {
+            print_usage(argv[0]);
+            return EXIT_SUCCESS;
+        } else {
+            options.mix.push_back(arg);
+        }
+    }
+    if (options.mix.empty()) {
+        options.mix.assign(std::begin(DEFAULT_MIX), std::end(DEFAULT_MIX));
+    }
+
+    Bench bench { .depth = options.depth };
+    for (const auto& text : options.mix) {
+        auto parsed = detail::split_line(text).and_then([](std::vector<std::string> words) {
+            return detail::parse_arguments(std::move(words));
+        });
+        if (!parsed) {
+            std::cerr << "cutter-bench: '" << text << "': " << parsed.error() << std::endl;
+            return EXIT_FAILURE;
+        }
+        if (std::holds_alternative<command_arguments::subscribe>(*parsed) || std::holds_alternative<command_arguments::quit>(*parsed)) {
+            std::cerr << "cutter-bench: '" << text << "' can't be benchmarked" << std::endl;
+            return EXIT_FAILURE;
+        }
+        bench.mix.push_back({ text, std::move(*parsed), {} });
+    }
+
+    HeadlessCompositor headless;
+    if (options.headless_compositor != nullptr && !start_headless(headless, options.headless_compositor)) {
+        return EXIT_FAILURE;
+    }
+
+    // the callbacks keep references to the connections, so they must not move once the benchmark starts
+    bench.connections.reserve(options.connections);
+    for (int i = 0; i < options.connections; i++) {
+        auto client = connect(headless);
+        if (!client) {
+            std::cerr << "cutter-bench: " << client.error() << std::endl;
+            return EXIT_FAILURE;
+        }
+        bench.connections.push_back({ std::move(*client), options.commands, static_cast<std::size_t>(i) });
+    }
+
+    auto start = Clock::now();
+    bool ok = bench.run();
+    double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::printf("connections: %d, depth: %d, commands: %zu, failed: %zu\n", options.connections, options.depth, bench.completed, bench.failed);
+    std::printf("elapsed: %.3f s, throughput: %.0f commands/s\n\n", elapsed, bench.completed / elapsed);
+
+    std::printf("%-24s %8s %10s %10s %10s\n", "command", "count", "p50 (us)", "p99 (us)", "max (us)");
+    std::vector<double> all;
+    for (auto& entry : bench.mix) {
+        all.insert(all.end(), entry.latencies.begin(), entry.latencies.end());
+        print_latencies(entry.text.c_str(), entry.latencies);
+    }
+    print_latencies("all", all);
+
+    return ok && bench.failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
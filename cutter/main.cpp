@@ -8,18 +8,106 @@ This program is distributed in the hope that it will be useful, but WITHOUT ANY
 
 You should have received a copy of the GNU General Public License along with this program. If not, see <https://www.gnu.org/licenses/>.
 */
+#include <cerrno>
 #include <cstdlib>
+#include <cstring>
+#include <fstream>
 #include <iostream>
 
 #include <cardboard/client.h>
 #include <cardboard/command_protocol.h>
+#include <cardboard/event_protocol.h>
 #include <cardboard/ipc.h>
 
 #include "parse_arguments.h"
+#include "print_state.h"
+
+/// Prints the events received after a \c subscribe command until the compositor closes the connection.
+int print_events(libcutter::Client& client, bool json)
+{
+    while (true) {
+        auto event = client.wait_event();
+        if (!event) {
+            if (event.error() == ECONNRESET) {
+                return EXIT_SUCCESS;
+            }
+            std::cerr << "cutter: error code " << event.error() << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        if (json) {
+            std::cout << *event << std::endl;
+            continue;
+        }
+
+        auto decoded = libcardboard::events::decode_binary(event->data(), event->size());
+        if (!decoded) {
+            std::cerr << "cutter: " << decoded.error() << std::endl;
+            return EXIT_FAILURE;
+        }
+        std::cout << libcardboard::events::type_name(decoded->type)
+                  << " workspace=" << decoded->workspace
+                  << " view=" << decoded->view
+                  << " output=" << decoded->output << std::endl;
+    }
+}
+
+/// Decodes and prints the snapshots returned by the \c get_* commands and the results of a batch, prints other responses as they are.
+bool print_response(const CommandData& command_data, const std::string& response)
+{
+    auto print_decoded = [&response](auto decoded) {
+        if (!decoded) {
+            std::cerr << "cutter: " << decoded.error() << std::endl;
+            return false;
+        }
+        print_state::print(std::cout, *decoded);
+        return true;
+    };
+
+    if (auto* get_tree = std::get_if<command_arguments::get_tree>(&command_data); get_tree && !get_tree->json) {
+        return print_decoded(libcardboard::state::read_tree(response.data(), response.size()));
+    }
+    if (auto* get_workspaces = std::get_if<command_arguments::get_workspaces>(&command_data); get_workspaces && !get_workspaces->json) {
+        return print_decoded(libcardboard::state::read_workspaces(response.data(), response.size()));
+    }
+    if (auto* get_outputs = std::get_if<command_arguments::get_outputs>(&command_data); get_outputs && !get_outputs->json) {
+        return print_decoded(libcardboard::state::read_outputs(response.data(), response.size()));
+    }
+    if (std::holds_alternative<command_arguments::batch>(command_data)) {
+        auto results = read_batch_results(response.data(), response.size());
+        if (!results) {
+            std::cerr << "cutter: " << results.error() << std::endl;
+            return false;
+        }
+
+        // messages of successful commands go to stdout, failures to stderr, one line per command
+        bool success = true;
+        for (std::size_t i = 0; i < results->size(); i++) {
+            const auto& result = (*results)[i];
+            if (result.success) {
+                std::cout << result.message << std::endl;
+            } else {
+                std::cerr << "cutter: command " << i + 1 << ": " << result.message << std::endl;
+                success = false;
+            }
+        }
+        return success;
+    }
+
+    std::cout << response;
+    if (std::holds_alternative<command_arguments::get_tree>(command_data)
+        || std::holds_alternative<command_arguments::get_workspaces>(command_data)
+        || std::holds_alternative<command_arguments::get_outputs>(command_data)) {
+        std::cout << std::endl;
+    }
+
+    return true;
+}
 
 void print_usage(char* argv0)
 {
     std::cerr << "Usage: " << argv0 << " <command> [args...]" << std::endl;
+    std::cerr << "       " << argv0 << " --batch [file]" << std::endl;
 }
 
 int main(int argc, char* argv[])
@@ -29,7 +117,23 @@ int main(int argc, char* argv[])
         return EXIT_FAILURE;
     }
 
-    CommandData command_data = parse_arguments(argc, argv)
+    auto parsed = [argc, argv]() -> tl::expected<CommandData, std::string> {
+        if (std::strcmp(argv[1], "--batch") != 0) {
+            return parse_arguments(argc, argv);
+        }
+
+        if (argc < 3 || std::strcmp(argv[2], "-") == 0) {
+            return parse_batch(std::cin);
+        }
+
+        std::ifstream file { argv[2] };
+        if (!file) {
+            return tl::unexpected(std::string("couldn't open ") + argv[2] + ": " + std::strerror(errno));
+        }
+        return parse_batch(file);
+    }();
+
+    CommandData command_data = std::move(parsed)
                                    .map_error([](const std::string& error) {
                                        std::cerr << "cutter: " << error << std::endl;
                                        exit(EXIT_FAILURE);
@@ -56,7 +160,13 @@ int main(int argc, char* argv[])
                                })
                                .value();
 
-    std::cout << response;
+    if (!print_response(command_data, response)) {
+        return EXIT_FAILURE;
+    }
+
+    if (auto* subscribe = std::get_if<command_arguments::subscribe>(&command_data)) {
+        return print_events(client, subscribe->json);
+    }
 
     return 0;
 }
@@ -11,6 +11,8 @@ You should have received a copy of the GNU General Public License along with thi
 #ifndef CUTTER_PARSE_ARGUMENTS_H_INCLUDED
 #define CUTTER_PARSE_ARGUMENTS_H_INCLUDED
 
+#include <cctype>
+#include <istream>
 #include <locale>
 #include <optional>
 #include <sstream>
@@ -21,6 +23,7 @@ You should have received a copy of the GNU General Public License along with thi
 #include <vector>
 
 #include <cardboard/command_protocol.h>
+#include <cardboard/event_protocol.h>
 
 namespace detail {
 using namespace std::string_literals;
@@ -81,6 +84,49 @@ tl::expected<CommandData, std::string> parse_config_focus_color(const std::vecto
         static_cast<float>(std::stoi(args[3])) / 255.f } };
 }
 
+tl::expected<CommandData, std::string> parse_config_chord_timeout(const std::vector<std::string>& args)
+{
+    if (args.size() != 1) {
+        return tl::unexpected("malformed config value"s);
+    }
+
+    return command_arguments::config { command_arguments::config::chord_timeout { std::stoi(args[0]) } };
+}
+
+/// Parses a key combination like <tt>super+shift+x</tt>.
+tl::expected<command_arguments::bind::key_combo, std::string> parse_key_combo(const std::string& combo)
+{
+    command_arguments::bind::key_combo key_combo;
+
+    auto locale = std::locale("");
+
+    size_t pos = 0;
+    while (pos < combo.size()) {
+        auto plus_index = combo.find('+', pos);
+        auto token = combo.substr(pos, plus_index - pos);
+
+        if (find_mod_key(token)) {
+            key_combo.modifiers.push_back(token);
+        } else {
+            for (char& c : token)
+                c = std::tolower(c, locale);
+            key_combo.key = token;
+        }
+
+        if (plus_index == combo.npos) {
+            pos = combo.size();
+        } else {
+            pos = plus_index + 1;
+        }
+    }
+
+    if (key_combo.key.empty()) {
+        return tl::unexpected("no key in key binding '"s + combo + "'");
+    }
+
+    return key_combo;
+}
+
 tl::expected<CommandData, std::string> parse_arguments(std::vector<std::string> arguments);
 
 tl::expected<CommandData, std::string> parse_quit(const std::vector<std::string>& args)
@@ -122,44 +168,48 @@ tl::expected<CommandData, std::string> parse_exec(const std::vector<std::string>
 
 tl::expected<CommandData, std::string> parse_bind(const std::vector<std::string>& args)
 {
-    std::vector<std::string> modifiers;
-    std::string key;
+    std::string mode;
+    std::vector<command_arguments::bind::key_combo> sequence;
 
-    auto locale = std::locale("");
+    auto arg_it = args.begin();
+    if (arg_it != args.end() && *arg_it == "--mode") {
+        if (std::next(arg_it) == args.end()) {
+            return tl::unexpected("no mode given to --mode"s);
+        }
+        mode = *std::next(arg_it);
+        arg_it += 2;
+    }
 
-    if (args.size() < 2) {
+    if (std::distance(arg_it, args.end()) < 2) {
         return tl::unexpected("not enough arguments"s);
     }
 
+    // chords are key combinations separated by commas: super+w,3
+    const std::string& keys = *arg_it;
     size_t pos = 0;
-    while (pos < args[0].size()) {
-        auto plus_index = args[0].find('+', pos);
-        auto token = args[0].substr(pos, plus_index - pos);
-
-        if (find_mod_key(token)) {
-            modifiers.push_back(token);
-        } else {
-            for (char& c : token)
-                c = std::tolower(c, locale);
-            key = token;
+    while (pos <= keys.size()) {
+        auto comma_index = keys.find(',', pos);
+        auto key_combo = parse_key_combo(keys.substr(pos, comma_index - pos));
+        if (!key_combo) {
+            return tl::unexpected(key_combo.error());
         }
+        sequence.push_back(std::move(*key_combo));
 
-        if (plus_index == args[0].npos) {
-            pos = args[0].size();
-        } else {
-            pos = plus_index + 1;
+        if (comma_index == keys.npos) {
+            break;
         }
+        pos = comma_index + 1;
     }
 
-    auto sub_command_args = std::vector(args.begin() + 1, args.end());
+    auto sub_command_args = std::vector(std::next(arg_it), args.end());
     auto command_data = parse_arguments(sub_command_args);
 
     if (!command_data.has_value())
         return tl::unexpected("could not parse sub command: \n"s + command_data.error());
 
     return command_arguments::bind {
-        std::move(modifiers),
-        std::move(key),
+        std::move(mode),
+        std::move(sequence),
         std::move(*command_data)
     };
 }
@@ -245,6 +295,8 @@ tl::expected<CommandData, std::string> parse_config(const std::vector<std::strin
         return parse_config_focus_color(new_args);
     } else if (key == "gap") {
         return parse_config_gap(new_args);
+    } else if (key == "chord_timeout") {
+        return parse_config_chord_timeout(new_args);
     }
 
     return tl::unexpected("invalid config key '"s + key + "''");
@@ -255,6 +307,110 @@ tl::expected<CommandData, std::string> parse_cycle_width(const std::vector<std::
     return command_arguments::cycle_width {};
 }
 
+tl::expected<CommandData, std::string> parse_mode(const std::vector<std::string>& args)
+{
+    if (args.empty()) {
+        return tl::unexpected("not enough arguments"s);
+    }
+
+    return command_arguments::mode { args[0] };
+}
+
+tl::expected<CommandData, std::string> parse_subscribe(const std::vector<std::string>& args)
+{
+    command_arguments::subscribe subscribe { 0, false };
+
+    for (const auto& arg : args) {
+        if (arg == "--json") {
+            subscribe.json = true;
+        } else if (auto type = libcardboard::events::type_from_name(arg)) {
+            subscribe.events |= libcardboard::events::type_mask(*type);
+        } else {
+            return tl::unexpected("unknown event '"s + arg + "'");
+        }
+    }
+
+    if (subscribe.events == 0) {
+        subscribe.events = libcardboard::events::ALL_TYPES;
+    }
+
+    return subscribe;
+}
+
+/// Parses the \c --json flag of the \c get_* commands, and \c --since if \a since is not null.
+tl::expected<bool, std::string> parse_get_flags(const std::vector<std::string>& args, uint64_t* since)
+{
+    bool json = false;
+
+    for (auto arg_it = args.begin(); arg_it != args.end(); ++arg_it) {
+        if (*arg_it == "--json") {
+            json = true;
+        } else if (*arg_it == "--since" && since != nullptr) {
+            if (++arg_it == args.end()) {
+                return tl::unexpected("no generation given to --since"s);
+            }
+            *since = std::stoull(*arg_it);
+        } else {
+            return tl::unexpected("unknown argument '"s + *arg_it + "'");
+        }
+    }
+
+    return json;
+}
+
+tl::expected<CommandData, std::string> parse_get_tree(const std::vector<std::string>& args)
+{
+    uint64_t since = 0;
+    return parse_get_flags(args, &since).map([&since](bool json) -> CommandData {
+        return command_arguments::get_tree { since, json };
+    });
+}
+
+tl::expected<CommandData, std::string> parse_get_workspaces(const std::vector<std::string>& args)
+{
+    return parse_get_flags(args, nullptr).map([](bool json) -> CommandData {
+        return command_arguments::get_workspaces { json };
+    });
+}
+
+tl::expected<CommandData, std::string> parse_get_outputs(const std::vector<std::string>& args)
+{
+    return parse_get_flags(args, nullptr).map([](bool json) -> CommandData {
+        return command_arguments::get_outputs { json };
+    });
+}
+
+tl::expected<CommandData, std::string> parse_noop(const std::vector<std::string>&)
+{
+    return command_arguments::noop {};
+}
+
+tl::expected<CommandData, std::string> parse_echo(const std::vector<std::string>& args)
+{
+    std::string payload;
+    for (const auto& arg : args) {
+        if (!payload.empty()) {
+            payload += ' ';
+        }
+        payload += arg;
+    }
+
+    return command_arguments::echo { std::move(payload) };
+}
+
+tl::expected<CommandData, std::string> parse_stats(const std::vector<std::string>& args)
+{
+    if (args.empty()) {
+        return tl::unexpected("not enough arguments"s);
+    }
+
+    if (args[0] == "startup") {
+        return command_arguments::stats { command_arguments::stats::Kind::Startup };
+    }
+
+    return tl::unexpected("unknown statistics '"s + args[0] + "'");
+}
+
 using parse_f = tl::expected<CommandData, std::string> (*)(const std::vector<std::string>&);
 static std::unordered_map<std::string, parse_f> parse_table = {
     { "quit", parse_quit },
@@ -270,6 +426,14 @@ static std::unordered_map<std::string, parse_f> parse_table = {
     { "pop_from_column", parse_pop_from_column },
     { "config", parse_config },
     { "cycle_width", parse_cycle_width },
+    { "mode", parse_mode },
+    { "subscribe", parse_subscribe },
+    { "get_tree", parse_get_tree },
+    { "get_workspaces", parse_get_workspaces },
+    { "get_outputs", parse_get_outputs },
+    { "noop", parse_noop },
+    { "echo", parse_echo },
+    { "stats", parse_stats },
 };
 
 tl::expected<CommandData, std::string> parse_arguments(std::vector<std::string> arguments)
@@ -299,4 +463,102 @@ tl::expected<CommandData, std::string> parse_arguments(int argc, char* argv[])
     return detail::parse_arguments(std::move(arguments));
 }
 
+namespace detail {
+/**
+ * \brief Splits a batch \a line into words like a POSIX shell would, without expansions.
+ *
+ * Words are separated by whitespace. Single quotes keep everything literally, double quotes
+ * and backslashes escape the next character, and an unquoted <tt>#</tt> starts a comment.
+ */
+tl::expected<std::vector<std::string>, std::string> split_line(const std::string& line)
+{
+    std::vector<std::string> words;
+    std::string word;
+    bool in_word = false;
+    char quote = '\0';
+
+    for (size_t i = 0; i < line.size(); i++) {
+        char c = line[i];
+
+        if (quote == '\'') {
+            if (c == '\'') {
+                quote = '\0';
+            } else {
+                word += c;
+            }
+        } else if (c == '\\') {
+            if (i + 1 == line.size()) {
+                return tl::unexpected("trailing backslash"s);
+            }
+            word += line[++i];
+            in_word = true;
+        } else if (quote == '"') {
+            if (c == '"') {
+                quote = '\0';
+            } else {
+                word += c;
+            }
+        } else if (c == '\'' || c == '"') {
+            quote = c;
+            in_word = true;
+        } else if (c == '#' && !in_word) {
+            break;
+        } else if (std::isspace(static_cast<unsigned char>(c))) {
+            if (in_word) {
+                words.push_back(std::move(word));
+                word.clear();
+                in_word = false;
+            }
+        } else {
+            word += c;
+            in_word = true;
+        }
+    }
+
+    if (quote != '\0') {
+        return tl::unexpected("unterminated quote"s);
+    }
+    if (in_word) {
+        words.push_back(std::move(word));
+    }
+
+    return words;
+}
+}
+
+/**
+ * \brief Parses one command per line from \a input into a single batch command.
+ *
+ * Empty lines and comments are skipped. Errors are prefixed with the line number.
+ */
+tl::expected<CommandData, std::string> parse_batch(std::istream& input)
+{
+    using namespace std::string_literals;
+
+    command_arguments::batch batch;
+
+    std::string line;
+    for (int line_number = 1; std::getline(input, line); line_number++) {
+        auto words = detail::split_line(line);
+        if (!words) {
+            return tl::unexpected("line "s + std::to_string(line_number) + ": " + words.error());
+        }
+        if (words->empty()) {
+            continue;
+        }
+
+        auto command_data = detail::parse_arguments(std::move(*words));
+        if (!command_data) {
+            return tl::unexpected("line "s + std::to_string(line_number) + ": " + command_data.error());
+        }
+        batch.commands.push_back(std::move(*command_data));
+    }
+
+    if (input.bad()) {
+        return tl::unexpected("couldn't read the batch input"s);
+    }
+
+    return batch;
+}
+
 #endif //CUTTER_PARSE_ARGUMENTS_H_INCLUDED
@@ -0,0 +1,79 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+Copyright (C) 2020 Alexandru-Iulian Magan, Tudor-Ioan Roman, and contributors.
+
+This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 3.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef CUTTER_PRINT_STATE_H_INCLUDED
+#define CUTTER_PRINT_STATE_H_INCLUDED
+
+#include <ostream>
+#include <vector>
+
+#include <cardboard/state_protocol.h>
+
+/// Human readable printing of the state snapshots returned by the \c get_* commands.
+namespace print_state {
+
+inline std::ostream& operator<<(std::ostream& out, const libcardboard::state::Box& box)
+{
+    return out << box.width << 'x' << box.height << '+' << box.x << '+' << box.y;
+}
+
+inline void print(std::ostream& out, const libcardboard::state::View& view)
+{
+    out << "    view " << view.id << ' ' << view.box << (view.fullscreen ? " fullscreen" : "") << '\n';
+}
+
+inline void print(std::ostream& out, const std::vector<libcardboard::state::Output>& outputs)
+{
+    for (const auto& output : outputs) {
+        out << "output " << output.name << ' ' << output.box
+            << " scale " << output.scale
+            << " usable " << output.usable_area << '\n';
+    }
+}
+
+inline void print(std::ostream& out, const std::vector<libcardboard::state::Workspace>& workspaces)
+{
+    for (const auto& workspace : workspaces) {
+        out << "workspace " << workspace.index;
+        if (!workspace.output.empty()) {
+            out << " on " << workspace.output;
+        }
+        out << " scroll " << workspace.scroll_x << '\n';
+
+        for (const auto& column : workspace.columns) {
+            out << "  column\n";
+            for (const auto& view : column.tiles) {
+                print(out, view);
+            }
+        }
+        if (!workspace.floating_views.empty()) {
+            out << "  floating\n";
+            for (const auto& view : workspace.floating_views) {
+                print(out, view);
+            }
+        }
+    }
+}
+
+inline void print(std::ostream& out, const libcardboard::state::Tree& tree)
+{
+    out << "generation " << tree.generation;
+    if (tree.since != 0) {
+        out << " since " << tree.since;
+    }
+    out << "\nfocused workspace " << tree.focused_workspace << " view " << tree.focused_view << '\n';
+
+    print(out, tree.outputs);
+    print(out, tree.workspaces);
+}
+
+}
+
+#endif // CUTTER_PRINT_STATE_H_INCLUDED
@@ -0,0 +1,140 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+Copyright (C) 2020 Alexandru-Iulian Magan, Tudor-Ioan Roman, and contributors.
+
+This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 3.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef LIBCARDBOARD_ASYNC_CLIENT_H_INCLUDED
+#define LIBCARDBOARD_ASYNC_CLIENT_H_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <tl/expected.hpp>
+
+#include "command_protocol.h"
+
+namespace libcutter {
+
+/**
+ * \brief Non-blocking connection to the Cardboard IPC server, meant to be driven by the event loop of the caller
+ *
+ * The client never blocks: AsyncClient::send_command only queues the request, and the I/O is done by
+ * AsyncClient::dispatch, which the caller runs whenever the file descriptor returned by AsyncClient::fd
+ * is ready for the events returned by AsyncClient::poll_events. Responses are delivered through callbacks
+ * or futures, in the order the commands were sent. Events of the subscription stream
+ * (see libcardboard::events) are delivered to the callback set with AsyncClient::on_event.
+ *
+ * \code{.cpp}
+ * auto client = libcutter::open_async_client().value();
+ * client.on_event([](std::string event) { ... });
+ * client.send_command(command_arguments::subscribe { libcardboard::events::ALL_TYPES, false }, [](auto) {});
+ *
+ * struct pollfd pfd = { client.fd(), 0, 0 };
+ * while (true) {
+ *     pfd.events = client.poll_events();
+ *     poll(&pfd, 1, -1);
+ *     if (client.dispatch() != 0) {
+ *         break;
+ *     }
+ * }
+ * \endcode
+ *
+ * The callbacks run inside AsyncClient::dispatch. They may send new commands, but must not destroy the client.
+ */
+class AsyncClient {
+public:
+    /// Receives the response of a command, or an \c errno value if the connection failed before it arrived.
+    using ResponseCallback = std::function<void(tl::expected<std::string, int>)>;
+    /// Receives an encoded event of the subscription stream.
+    using EventCallback = std::function<void(std::string)>;
+
+    AsyncClient(const AsyncClient&) = delete;
+    AsyncClient(AsyncClient&&) noexcept;
+    ~AsyncClient();
+
+    /// The file descriptor to watch in the event loop of the caller.
+    int fd() const;
+
+    /// The \c poll events to watch the file descriptor for: \c POLLIN, and \c POLLOUT while there are requests to send.
+    short poll_events() const;
+
+    /// Returns true if some requests couldn't be sent completely yet.
+    bool wants_write() const;
+
+    /**
+     * \brief Queues a command to be sent by the next AsyncClient::dispatch
+     *
+     * \return the id of the request
+     */
+    tl::expected<uint32_t, std::string> send_command(const CommandData&, ResponseCallback callback);
+
+    /**
+     * \brief Queues a command, returning a future that becomes ready when AsyncClient::dispatch receives the response.
+     *
+     * If the command can't be queued, the future is ready right away with the reason: \c EMSGSIZE if the command
+     * is too large, \c ECONNRESET if the connection already failed.
+     */
+    std::future<tl::expected<std::string, int>> send_command(const CommandData&);
+
+    /// Sets the callback that receives the events the client subscribed to.
+    void on_event(EventCallback callback);
+
+    /**
+     * \brief Sends the queued requests and receives the available responses and events, without blocking
+     *
+     * \return 0, or an \c errno value if the connection failed. \c ECONNRESET means the server closed the connection.
+     * In case of failure, the callbacks of the commands still waiting for a response receive the error.
+     */
+    int dispatch();
+
+    /// Returns the number of commands sent whose responses have not been received yet.
+    std::size_t pending_responses() const;
+
+private:
+    explicit AsyncClient(int socket_fd);
+
+    /// Encodes a command into the output. Returns the id of the request or an \c errno value.
+    tl::expected<uint32_t, int> queue_command(const CommandData&, ResponseCallback callback);
+    /// Writes as much of the output as the socket accepts. Returns 0 or an \c errno value.
+    int flush();
+    /// Reads everything available and delivers the complete messages. Returns 0 or an \c errno value.
+    int receive();
+    /// Fails all the pending requests with \a error and returns it.
+    int fail(int error);
+
+    int socket_fd;
+
+    uint32_t next_request_id = 1;
+    /// Requests waiting for a response, oldest first.
+    std::deque<std::pair<uint32_t, ResponseCallback>> pending_requests;
+    EventCallback event_callback;
+
+    /// Encoded requests not written yet, starting at \c output_offset.
+    std::string output;
+    std::size_t output_offset = 0;
+    /// Received bytes that don't form a complete message yet, starting at \c input_offset.
+    std::vector<std::byte> input;
+    std::size_t input_offset = 0;
+
+    friend tl::expected<AsyncClient, std::string> open_async_client();
+};
+
+/**
+ * \brief Creates a non-blocking client connection on the socket path reported by the system
+ */
+tl::expected<AsyncClient, std::string> open_async_client();
+
+}
+
+#endif // LIBCARDBOARD_ASYNC_CLIENT_H_INCLUDED
@@ -11,8 +11,11 @@ You should have received a copy of the GNU General Public License along with thi
 #ifndef LIBCARDBOARD_CLIENT_H_INCLUDED
 #define LIBCARDBOARD_CLIENT_H_INCLUDED
 
+#include <cstdint>
+#include <deque>
 #include <memory>
 #include <string>
+#include <utility>
 
 #include <tl/expected.hpp>
 
@@ -25,6 +28,10 @@ namespace libcutter {
 
 /**
  * \brief Manages a connection to the Cardboard IPC server
+ *
+ * The connection is a session that can be used for any number of commands.
+ * Commands can be pipelined: send several of them with Client::send_command, then collect
+ * the responses with Client::wait_response, which returns them in the order the commands were sent.
  */
 class Client {
 public:
@@ -34,20 +41,45 @@ public:
 
     /**
      * \brief Serializes and sends a CommandData packet to the server
+     *
+     * \return the id of the request
      */
-    tl::expected<void, std::string> send_command(const CommandData&);
+    tl::expected<uint32_t, std::string> send_command(const CommandData&);
 
     /**
-     * \brief Waits for a string response from the server
+     * \brief Waits for the string response of the oldest command that has not been answered yet
+     *
+     * \return the response, or an \c errno value. \c ECONNRESET means the server closed the connection.
      */
     tl::expected<std::string, int> wait_response();
 
+    /**
+     * \brief Waits for the next event pushed by the server, after a \c subscribe command
+     *
+     * Events received while waiting for responses are kept and returned first.
+     *
+     * \return the encoded event, or an \c errno value. \c ECONNRESET means the server closed the connection.
+     */
+    tl::expected<std::string, int> wait_event();
+
+    /// Returns the number of commands sent whose responses have not been received yet.
+    std::size_t pending_responses() const;
+
 private:
     Client(int, std::unique_ptr<sockaddr_un>);
 
+    /// Reads one message from the socket, returning its request id and its payload.
+    tl::expected<std::pair<uint32_t, std::string>, int> read_message();
+
     int socket_fd;
     std::unique_ptr<sockaddr_un> socket_address;
 
+    uint32_t next_request_id = 1;
+    /// Ids of the requests waiting for a response, oldest first.
+    std::deque<uint32_t> pending_requests;
+    /// Events received while waiting for a response.
+    std::deque<std::string> received_events;
+
     friend tl::expected<Client, std::string> open_client();
 };
 
@@ -56,6 +88,16 @@ private:
  */
 tl::expected<Client, std::string> open_client();
 
+/**
+ * \brief Connects a new socket to the IPC server, on the socket path reported by the system
+ *
+ * The connection itself is always blocking: Unix sockets connect immediately.
+ *
+ * \param socket_flags - extra \c socket(2) type flags, like \c SOCK_CLOEXEC
+ * \return the file descriptor of the socket
+ */
+tl::expected<int, std::string> connect_to_server(sockaddr_un& socket_address, int socket_flags = 0);
+
 }
 
 #endif //LIBCARDBOARD_CLIENT_H_INCLUDED
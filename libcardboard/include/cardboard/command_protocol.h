@@ -11,6 +11,7 @@ You should have received a copy of the GNU General Public License along with thi
 #ifndef LIBCARDBOARD_COMMAND_PROTOCOL_H_INCLUDED
 #define LIBCARDBOARD_COMMAND_PROTOCOL_H_INCLUDED
 
+#include <cstdint>
 #include <memory>
 #include <optional>
 #include <string>
@@ -87,11 +88,59 @@ struct config {
         float r, g, b, a;
     };
 
-    std::variant<mouse_mod, gap, focus_color> config;
+    struct chord_timeout {
+        int milliseconds;
+    };
+
+    std::variant<mouse_mod, gap, focus_color, chord_timeout> config;
 };
 
 struct cycle_width {
 };
+
+struct mode {
+    std::string name;
+};
+
+struct batch;
+
+/// Turns the connection into a stream of events. See libcardboard::events.
+struct subscribe {
+    uint32_t events; ///< Mask of libcardboard::events::type_mask values.
+    bool json; ///< Send the events as JSON instead of the binary form.
+};
+
+/// Returns a libcardboard::state::Tree, see state_protocol.h.
+struct get_tree {
+    uint64_t since; ///< 0 for the full tree, otherwise only the changes after this generation are returned.
+    bool json;
+};
+
+/// Returns the list of libcardboard::state::Workspace.
+struct get_workspaces {
+    bool json;
+};
+
+/// Returns the list of libcardboard::state::Output.
+struct get_outputs {
+    bool json;
+};
+
+/// Does nothing and returns an empty response, to measure the cost of the IPC itself.
+struct noop {
+};
+
+/// Returns its payload unchanged, to measure the IPC cost of payloads of a given size.
+struct echo {
+    std::string payload;
+};
+
+/// Returns statistics of the compositor, as text.
+struct stats {
+    enum class Kind {
+        Startup, ///< The timestamps of the startup phases.
+    } kind;
+};
 }
 
 /**
@@ -110,26 +159,46 @@ using CommandData = std::variant<
     command_arguments::insert_into_column,
     command_arguments::pop_from_column,
     command_arguments::config,
-    command_arguments::cycle_width>;
+    command_arguments::cycle_width,
+    command_arguments::mode,
+    command_arguments::batch,
+    command_arguments::subscribe,
+    command_arguments::get_tree,
+    command_arguments::get_workspaces,
+    command_arguments::get_outputs,
+    command_arguments::noop,
+    command_arguments::echo,
+    command_arguments::stats>;
 
 namespace command_arguments {
+/// Commands executed in order, under a single layout transaction. The result is one BatchResult per command, see write_batch_results.
+struct batch {
+    std::vector<CommandData> commands;
+};
+
 struct bind {
-    std::vector<std::string> modifiers;
-    std::string key;
+    /// A key pressed together with some modifiers.
+    struct key_combo {
+        std::vector<std::string> modifiers;
+        std::string key;
+    };
+
+    std::string mode; ///< The mode in which the binding is active, empty for the default mode.
+    std::vector<key_combo> sequence; ///< Key combinations pressed one after another, more than one for chords.
     std::unique_ptr<CommandData> command;
 
     bind() = default;
 
-    bind(std::vector<std::string> modifiers, std::string key, CommandData command)
-        : modifiers { std::move(modifiers) }
-        , key { std::move(key) }
+    bind(std::string mode, std::vector<key_combo> sequence, CommandData command)
+        : mode { std::move(mode) }
+        , sequence { std::move(sequence) }
         , command { std::make_unique<CommandData>(std::move(command)) }
     {
     }
 
     bind(const bind& other)
-        : modifiers { other.modifiers }
-        , key { other.key }
+        : mode { other.mode }
+        , sequence { other.sequence }
         , command { std::make_unique<CommandData>(*other.command) }
     {
     }
@@ -142,8 +211,8 @@ struct bind {
         if (&other == this)
             return *this;
 
-        modifiers = other.modifiers;
-        key = other.key;
+        mode = other.mode;
+        sequence = other.sequence;
         command = std::make_unique<CommandData>(*other.command);
 
         return *this;
@@ -153,12 +222,26 @@ struct bind {
 
 /**
  * \brief Deserializes data from a region of memory
+ *
+ * The data is decoded in place, without being copied first.
  */
-tl::expected<CommandData, std::string> read_command_data(void* data, size_t);
+tl::expected<CommandData, std::string> read_command_data(const void* data, size_t);
 
 /**
  * \brief Serializes CommandData type data into a std::string buffer
  */
 tl::expected<std::string, std::string> write_command_data(const CommandData&);
 
+/// The result of one of the commands of a command_arguments::batch.
+struct BatchResult {
+    bool success;
+    std::string message;
+};
+
+/// Serializes the results of the commands of a batch, in the order the commands ran.
+std::string write_batch_results(const std::vector<BatchResult>&);
+
+/// Deserializes the results serialized by write_batch_results.
+tl::expected<std::vector<BatchResult>, std::string> read_batch_results(const void* data, size_t);
+
 #endif //LIBCARDBOARD_COMMAND_PROTOCOL_H_INCLUDED
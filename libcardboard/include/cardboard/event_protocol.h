@@ -0,0 +1,89 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+Copyright (C) 2020 Alexandru-Iulian Magan, Tudor-Ioan Roman, and contributors.
+
+This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 3.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef LIBCARDBOARD_EVENT_PROTOCOL_H_INCLUDED
+#define LIBCARDBOARD_EVENT_PROTOCOL_H_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include <tl/expected.hpp>
+
+/**
+ * \brief Events pushed by the compositor to the clients that subscribed to them.
+ *
+ * A client subscribes with the \c subscribe command. From then on, the server sends the events
+ * on the same connection, as messages with the request id 0, either in the compact binary form
+ * of encode_binary or as JSON objects. The events of one event loop iteration are coalesced:
+ * only the last focus change is sent, and duplicates are dropped. When a client doesn't read
+ * its events fast enough, the oldest ones are dropped.
+ */
+namespace libcardboard::events {
+
+enum class Type : uint8_t {
+    ViewFocused = 0, ///< The focused view changed. \c view is 0 if nothing is focused anymore.
+    WorkspaceFocused,
+    ViewMapped,
+    ViewUnmapped,
+    OutputAdded,
+    OutputRemoved,
+    /// The layout of a workspace changed. Use the \c get_tree command to get the changes.
+    WorkspaceChanged,
+};
+
+constexpr std::size_t TYPE_COUNT = 7;
+
+/// Returns the bit of the subscription mask corresponding to \a type.
+constexpr uint32_t type_mask(Type type)
+{
+    return 1u << static_cast<uint32_t>(type);
+}
+
+/// Subscription mask that includes all the events.
+constexpr uint32_t ALL_TYPES = (1u << TYPE_COUNT) - 1;
+
+struct Event {
+    Type type;
+    int32_t workspace = -1; ///< Index of the workspace, -1 if not relevant.
+    uint32_t view = 0; ///< Id of the view, 0 if not relevant.
+    std::string output {}; ///< Name of the output, empty if not relevant.
+
+    bool operator==(const Event& other) const
+    {
+        return type == other.type && workspace == other.workspace && view == other.view && output == other.output;
+    }
+};
+
+/// Returns the name of the event \a type, like \c view_focused.
+std::string_view type_name(Type type);
+
+/// Returns the event type called \a name.
+std::optional<Type> type_from_name(std::string_view name);
+
+/**
+ * \brief Serializes \a event in the binary form
+ *
+ * The layout is: type (1 byte), workspace (4 bytes), view (4 bytes), length of the output name (1 byte)
+ * and the output name. Integers are little endian.
+ */
+std::string encode_binary(const Event& event);
+
+/// Serializes \a event as a single line JSON object.
+std::string encode_json(const Event& event);
+
+/// Deserializes an event serialized by encode_binary.
+tl::expected<Event, std::string> decode_binary(const void* data, std::size_t size);
+
+}
+
+#endif // LIBCARDBOARD_EVENT_PROTOCOL_H_INCLUDED
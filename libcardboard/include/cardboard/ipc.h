@@ -20,15 +20,29 @@ namespace libcardboard::ipc {
 
 /**
  * \brief The IPC header that describes the payload
+ *
+ * Every request and every response on the socket is a header followed by \c incoming_bytes bytes of payload.
+ * A connection can carry any number of requests, and the client doesn't have to wait for a response before
+ * sending the next request. The server answers the requests in the order it received them,
+ * tagging each response with the \c request_id of its request.
  */
 struct Header {
     int incoming_bytes;
+    /// Chosen by the client to match responses to requests. Zero is reserved for messages initiated by the server.
+    uint32_t request_id;
 };
 
 /**
  * \brief The size of the IPC header in bytes
  */
-constexpr std::size_t HEADER_SIZE = 4;
+constexpr std::size_t HEADER_SIZE = 8;
+
+/**
+ * \brief The maximum size of the payload of a request
+ *
+ * The server disconnects the clients that announce larger requests, so that it never has to buffer them.
+ */
+constexpr std::size_t MAX_PAYLOAD_SIZE = 1 << 20;
 
 /**
  * \brief Buffer type where the IPC header can be stored for fast serialization and deserialization
@@ -36,6 +50,12 @@ constexpr std::size_t HEADER_SIZE = 4;
 struct alignas(alignof(Header)) AlignedHeaderBuffer : std::array<std::byte, HEADER_SIZE> {
 };
 
+/// Reads a little endian 32 bit unsigned integer from \a data.
+uint32_t read_u32(const std::byte* data);
+
+/// Writes \a value to \a data as a little endian 32 bit unsigned integer.
+void write_u32(std::byte* data, uint32_t value);
+
 /**
  * \brief Deserializes the data in the buffer into a Header value
  */
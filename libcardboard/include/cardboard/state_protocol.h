@@ -0,0 +1,95 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+Copyright (C) 2020 Alexandru-Iulian Magan, Tudor-Ioan Roman, and contributors.
+
+This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 3.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef LIBCARDBOARD_STATE_PROTOCOL_H_INCLUDED
+#define LIBCARDBOARD_STATE_PROTOCOL_H_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <tl/expected.hpp>
+
+/**
+ * \brief Snapshots of the compositor state, returned by the \c get_tree, \c get_workspaces and \c get_outputs commands.
+ *
+ * Every change of the layout increments a generation counter. A client that mirrors the layout can keep
+ * the generation of its last Tree and ask for a diff since that generation: the server then sends only
+ * the workspaces that changed after it, and the outputs only if they changed.
+ *
+ * The snapshots are serialized with the portable binary archive of the commands, or as JSON on request.
+ */
+namespace libcardboard::state {
+
+/// A rectangle in output layout coordinates.
+struct Box {
+    int x, y, width, height;
+};
+
+struct View {
+    uint32_t id;
+    Box box; ///< The position and the size given to the view by the compositor.
+    bool fullscreen;
+};
+
+struct Column {
+    std::vector<View> tiles; ///< From top to bottom.
+};
+
+struct Workspace {
+    int32_t index;
+    std::string output; ///< Name of the output showing the workspace, empty if it's not shown.
+    int scroll_x; ///< The offset of the viewport.
+    std::vector<Column> columns; ///< From left to right.
+    std::vector<View> floating_views;
+};
+
+struct Output {
+    std::string name;
+    Box box;
+    Box usable_area; ///< The area not covered by exclusive layer surfaces like bars, relative to the output.
+    float scale;
+};
+
+struct Tree {
+    uint64_t generation; ///< The generation of the layout this tree describes.
+    uint64_t since; ///< 0 for a full tree, otherwise the generation this tree is a diff from.
+    int32_t focused_workspace; ///< -1 if there is no focused workspace.
+    uint32_t focused_view; ///< 0 if there is no focused view.
+    bool outputs_changed; ///< Always true in a full tree. If false, \c outputs is empty and the outputs didn't change.
+    std::vector<Output> outputs;
+    std::vector<Workspace> workspaces; ///< All the workspaces in a full tree, only the changed ones in a diff.
+};
+
+/// Serializes \a tree in the portable binary form.
+std::string write_tree(const Tree& tree);
+/// Deserializes a tree serialized by write_tree.
+tl::expected<Tree, std::string> read_tree(const void* data, std::size_t size);
+/// Serializes \a tree as a single line JSON object.
+std::string tree_to_json(const Tree& tree);
+
+/// Serializes \a workspaces in the portable binary form.
+std::string write_workspaces(const std::vector<Workspace>& workspaces);
+/// Deserializes a list of workspaces serialized by write_workspaces.
+tl::expected<std::vector<Workspace>, std::string> read_workspaces(const void* data, std::size_t size);
+/// Serializes \a workspaces as a single line JSON array.
+std::string workspaces_to_json(const std::vector<Workspace>& workspaces);
+
+/// Serializes \a outputs in the portable binary form.
+std::string write_outputs(const std::vector<Output>& outputs);
+/// Deserializes a list of outputs serialized by write_outputs.
+tl::expected<std::vector<Output>, std::string> read_outputs(const void* data, std::size_t size);
+/// Serializes \a outputs as a single line JSON array.
+std::string outputs_to_json(const std::vector<Output>& outputs);
+
+}
+
+#endif // LIBCARDBOARD_STATE_PROTOCOL_H_INCLUDED
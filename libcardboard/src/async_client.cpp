@@ -0,0 +1,284 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+Copyright (C) 2020 Alexandru-Iulian Magan, Tudor-Ioan Roman, and contributors.
+
+This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 3.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <cardboard/ipc.h>
+#include <include/cardboard/async_client.h>
+#include <include/cardboard/client.h>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <memory>
+
+namespace libcutter {
+
+/// How much is read from the socket at once.
+static constexpr std::size_t READ_CHUNK_SIZE = 4096;
+
+AsyncClient::AsyncClient(int socket_fd)
+    : socket_fd { socket_fd }
+{
+}
+
+AsyncClient::AsyncClient(AsyncClient&& other) noexcept
+    : socket_fd { other.socket_fd }
+    , next_request_id { other.next_request_id }
+    , pending_requests { std::move(other.pending_requests) }
+    , event_callback { std::move(other.event_callback) }
+    , output { std::move(other.output) }
+    , output_offset { other.output_offset }
+    , input { std::move(other.input) }
+    , input_offset { other.input_offset }
+{
+    other.socket_fd = -1;
+}
+
+AsyncClient::~AsyncClient()
+{
+    if (socket_fd != -1) {
+        close(socket_fd);
+    }
+}
+
+int AsyncClient::fd() const
+{
+    return socket_fd;
+}
+
+short AsyncClient::poll_events() const
+{
+    return wants_write() ? POLLIN | POLLOUT : POLLIN;
+}
+
+bool AsyncClient::wants_write() const
+{
+    return output_offset < output.size();
+}
+
+tl::expected<uint32_t, std::string> AsyncClient::send_command(const CommandData& command_data, ResponseCallback callback)
+{
+    return queue_command(command_data, std::move(callback)).map_error([](int error) {
+        return std::string { std::strerror(error) };
+    });
+}
+
+std::future<tl::expected<std::string, int>> AsyncClient::send_command(const CommandData& command_data)
+{
+    // std::function needs a copyable callable, so the promise is shared with the callback
+    auto promise = std::make_shared<std::promise<tl::expected<std::string, int>>>();
+    auto future = promise->get_future();
+
+    if (auto queued = queue_command(command_data, [promise](tl::expected<std::string, int> response) { promise->set_value(std::move(response)); }); !queued) {
+        promise->set_value(tl::unexpected(queued.error()));
+    }
+
+    return future;
+}
+
+tl::expected<uint32_t, int> AsyncClient::queue_command(const CommandData& command_data, ResponseCallback callback)
+{
+    if (socket_fd == -1) {
+        return tl::unexpected(ECONNRESET);
+    }
+
+    auto buffer = write_command_data(command_data);
+
+    if (!buffer) {
+        return tl::unexpected(EINVAL);
+    }
+    if (buffer->size() > libcardboard::ipc::MAX_PAYLOAD_SIZE) {
+        return tl::unexpected(EMSGSIZE);
+    }
+
+    uint32_t request_id = next_request_id++;
+    if (next_request_id == 0) {
+        // 0 is reserved for messages initiated by the server
+        next_request_id = 1;
+    }
+
+    libcardboard::ipc::AlignedHeaderBuffer header_buffer = libcardboard::ipc::create_header_buffer({ static_cast<int>(buffer->size()), request_id });
+    output.append(reinterpret_cast<const char*>(header_buffer.data()), libcardboard::ipc::HEADER_SIZE);
+    output.append(*buffer);
+
+    pending_requests.emplace_back(request_id, std::move(callback));
+    return request_id;
+}
+
+void AsyncClient::on_event(EventCallback callback)
+{
+    event_callback = std::move(callback);
+}
+
+int AsyncClient::dispatch()
+{
+    if (socket_fd == -1) {
+        return fail(ECONNRESET);
+    }
+
+    if (int err = flush(); err != 0) {
+        return fail(err);
+    }
+    if (int err = receive(); err != 0) {
+        return fail(err);
+    }
+
+    // callbacks may have queued new requests
+    if (int err = flush(); err != 0) {
+        return fail(err);
+    }
+
+    return 0;
+}
+
+std::size_t AsyncClient::pending_responses() const
+{
+    return pending_requests.size();
+}
+
+int AsyncClient::flush()
+{
+    while (output_offset < output.size()) {
+        // MSG_NOSIGNAL: a library shouldn't depend on the application ignoring SIGPIPE
+        ssize_t written = send(socket_fd, output.data() + output_offset, output.size() - output_offset, MSG_NOSIGNAL);
+        if (written == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return 0;
+            }
+            // report a closed connection the same way as receive does
+            return errno == EPIPE ? ECONNRESET : errno;
+        }
+
+        output_offset += written;
+    }
+
+    output.clear();
+    output_offset = 0;
+    return 0;
+}
+
+int AsyncClient::receive()
+{
+    bool closed = false;
+    while (true) {
+        std::size_t old_size = input.size();
+        input.resize(old_size + READ_CHUNK_SIZE);
+
+        ssize_t received = recv(socket_fd, input.data() + old_size, READ_CHUNK_SIZE, 0);
+        input.resize(old_size + std::max<ssize_t>(received, 0));
+        if (received == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
+            return errno;
+        }
+        if (received == 0) {
+            closed = true;
+            break;
+        }
+    }
+
+    // deliver the complete messages
+    while (input.size() - input_offset >= libcardboard::ipc::HEADER_SIZE) {
+        libcardboard::ipc::AlignedHeaderBuffer header_buffer;
+        std::memcpy(header_buffer.data(), input.data() + input_offset, libcardboard::ipc::HEADER_SIZE);
+        libcardboard::ipc::Header header = libcardboard::ipc::interpret_header(header_buffer);
+        if (header.incoming_bytes < 0) {
+            return EPROTO;
+        }
+
+        std::size_t message_size = libcardboard::ipc::HEADER_SIZE + header.incoming_bytes;
+        if (input.size() - input_offset < message_size) {
+            break;
+        }
+
+        std::string payload(reinterpret_cast<const char*>(input.data() + input_offset + libcardboard::ipc::HEADER_SIZE), header.incoming_bytes);
+        input_offset += message_size;
+
+        if (header.request_id == 0) {
+            if (event_callback) {
+                event_callback(std::move(payload));
+            }
+            continue;
+        }
+
+        if (pending_requests.empty() || pending_requests.front().first != header.request_id) {
+            return EPROTO;
+        }
+        // pop before calling, the callback may send new commands
+        ResponseCallback callback = std::move(pending_requests.front().second);
+        pending_requests.pop_front();
+        if (callback) {
+            callback(std::move(payload));
+        }
+    }
+
+    // keep only the incomplete message
+    input.erase(input.begin(), input.begin() + input_offset);
+    input_offset = 0;
+    if (input.empty()) {
+        input.shrink_to_fit();
+    }
+
+    return closed ? ECONNRESET : 0;
+}
+
+int AsyncClient::fail(int error)
+{
+    if (socket_fd != -1) {
+        close(socket_fd);
+        socket_fd = -1;
+    }
+    output.clear();
+    output_offset = 0;
+    input.clear();
+    input_offset = 0;
+
+    auto requests = std::move(pending_requests);
+    pending_requests.clear();
+    for (auto& [request_id, callback] : requests) {
+        if (callback) {
+            callback(tl::unexpected(error));
+        }
+    }
+
+    return error;
+}
+
+tl::expected<AsyncClient, std::string> open_async_client()
+{
+    using namespace std::string_literals;
+
+    sockaddr_un socket_address;
+    auto socket_fd = connect_to_server(socket_address, SOCK_CLOEXEC);
+    if (!socket_fd) {
+        return tl::unexpected(socket_fd.error());
+    }
+
+    // connect first, then switch to non-blocking, so that the connection is established when the client is returned
+    if (int flags = fcntl(*socket_fd, F_GETFL); flags == -1 || fcntl(*socket_fd, F_SETFL, flags | O_NONBLOCK) == -1) {
+        close(*socket_fd);
+        return tl::unexpected("Unable to make the socket non-blocking"s);
+    }
+
+    return AsyncClient { *socket_fd };
+}
+}
@@ -12,17 +12,71 @@ You should have received a copy of the GNU General Public License along with thi
 #include <include/cardboard/client.h>
 
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <sys/un.h>
 #include <unistd.h>
 
+#include <cerrno>
+#include <cstring>
+
 namespace libcutter {
 
+/// Reads exactly \a size bytes, retrying on short reads. Returns 0 or an \c errno value.
+static int read_exactly(int fd, void* buffer, std::size_t size)
+{
+    auto* data = static_cast<std::byte*>(buffer);
+    while (size > 0) {
+        ssize_t received = recv(fd, data, size, 0);
+        if (received == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return errno;
+        }
+        if (received == 0) {
+            return ECONNRESET;
+        }
+
+        data += received;
+        size -= received;
+    }
+
+    return 0;
+}
+
+/// Writes all the buffers described by \a iov, retrying on short writes. Returns 0 or an \c errno value.
+static int write_all(int fd, struct iovec* iov, int iov_count)
+{
+    while (iov_count > 0) {
+        ssize_t written = writev(fd, iov, iov_count);
+        if (written == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return errno;
+        }
+
+        // skip what has been written
+        while (iov_count > 0 && static_cast<std::size_t>(written) >= iov->iov_len) {
+            written -= iov->iov_len;
+            iov++;
+            iov_count--;
+        }
+        if (iov_count > 0) {
+            iov->iov_base = static_cast<std::byte*>(iov->iov_base) + written;
+            iov->iov_len -= written;
+        }
+    }
+
+    return 0;
+}
+
 libcutter::Client::~Client()
 {
     close(socket_fd);
 }
 
-tl::expected<void, std::string> libcutter::Client::send_command(const CommandData& command_data)
+tl::expected<uint32_t, std::string> libcutter::Client::send_command(const CommandData& command_data)
 {
     using namespace std::string_literals;
 
@@ -31,49 +85,99 @@ tl::expected<void, std::string> libcutter::Client::send_command(const CommandDat
     if (!buffer) {
         return tl::unexpected(buffer.error());
     }
+    if (buffer->size() > libcardboard::ipc::MAX_PAYLOAD_SIZE) {
+        return tl::unexpected("command too large"s);
+    }
 
-    libcardboard::ipc::AlignedHeaderBuffer header_buffer = libcardboard::ipc::create_header_buffer({ static_cast<int>(buffer->size() + 1) });
-
-    if (write(socket_fd, header_buffer.data(), libcardboard::ipc::HEADER_SIZE) == -1) {
-        int err = errno;
-        return tl::unexpected("unable to write payload: "s + strerror(err));
+    uint32_t request_id = next_request_id++;
+    if (next_request_id == 0) {
+        // 0 is reserved for messages initiated by the server
+        next_request_id = 1;
     }
 
-    if (write(socket_fd, buffer->c_str(), buffer->size() + 1) == -1) {
-        int err = errno;
+    libcardboard::ipc::AlignedHeaderBuffer header_buffer = libcardboard::ipc::create_header_buffer({ static_cast<int>(buffer->size()), request_id });
+
+    struct iovec iov[2] = {
+        { header_buffer.data(), libcardboard::ipc::HEADER_SIZE },
+        { buffer->data(), buffer->size() },
+    };
+    if (int err = write_all(socket_fd, iov, 2); err != 0) {
         return tl::unexpected("unable to write payload: "s + strerror(err));
     }
 
-    return {};
+    pending_requests.push_back(request_id);
+    return request_id;
 }
 
 tl::expected<std::string, int> libcutter::Client::wait_response()
 {
-    libcardboard::ipc::AlignedHeaderBuffer buffer;
-
-    if (recv(socket_fd, buffer.data(), libcardboard::ipc::HEADER_SIZE, 0) == libcardboard::ipc::HEADER_SIZE) {
-        libcardboard::ipc::Header header = libcardboard::ipc::interpret_header(buffer);
+    if (pending_requests.empty()) {
+        return tl::unexpected(EINVAL);
+    }
 
-        if (header.incoming_bytes == 0) {
-            return std::string {};
+    while (true) {
+        auto message = read_message();
+        if (!message) {
+            return tl::unexpected(message.error());
         }
 
-        auto* response_buffer = new std::byte[header.incoming_bytes];
-        if (recv(socket_fd, response_buffer, sizeof(header.incoming_bytes), 0) == header.incoming_bytes) {
-            return std::string(reinterpret_cast<char*>(response_buffer));
-        } else {
-            int err = errno;
-            return tl::unexpected(err);
+        auto& [request_id, payload] = *message;
+        if (request_id == 0) {
+            received_events.push_back(std::move(payload));
+            continue;
         }
-    } else {
-        int err = errno;
-
-        if (err == EBADF) {
-            return std::string {};
+        if (request_id != pending_requests.front()) {
+            return tl::unexpected(EPROTO);
         }
+        pending_requests.pop_front();
+
+        return std::move(payload);
+    }
+}
+
+tl::expected<std::string, int> libcutter::Client::wait_event()
+{
+    if (!received_events.empty()) {
+        std::string event = std::move(received_events.front());
+        received_events.pop_front();
+        return event;
+    }
 
+    auto message = read_message();
+    if (!message) {
+        return tl::unexpected(message.error());
+    }
+    if (message->first != 0) {
+        // a response to a request nobody is waiting for
+        return tl::unexpected(EPROTO);
+    }
+
+    return std::move(message->second);
+}
+
+tl::expected<std::pair<uint32_t, std::string>, int> libcutter::Client::read_message()
+{
+    libcardboard::ipc::AlignedHeaderBuffer buffer;
+    if (int err = read_exactly(socket_fd, buffer.data(), libcardboard::ipc::HEADER_SIZE); err != 0) {
+        return tl::unexpected(err);
+    }
+
+    libcardboard::ipc::Header header = libcardboard::ipc::interpret_header(buffer);
+    if (header.incoming_bytes < 0) {
+        return tl::unexpected(EPROTO);
+    }
+
+    std::string payload(header.incoming_bytes, '\0');
+    if (int err = read_exactly(socket_fd, payload.data(), payload.size()); err != 0) {
         return tl::unexpected(err);
     }
+
+    return std::pair { header.request_id, std::move(payload) };
+}
+
+std::size_t libcutter::Client::pending_responses() const
+{
+    return pending_requests.size();
 }
 
 Client::Client(int socket_fd, std::unique_ptr<sockaddr_un> socket_address)
@@ -85,19 +189,17 @@ Client::Client(int socket_fd, std::unique_ptr<sockaddr_un> socket_address)
 Client::Client(Client&& other) noexcept
     : socket_fd { other.socket_fd }
     , socket_address { std::move(other.socket_address) }
+    , next_request_id { other.next_request_id }
+    , pending_requests { std::move(other.pending_requests) }
+    , received_events { std::move(other.received_events) }
 {
     other.socket_fd = -1;
 }
 
-tl::expected<Client, std::string> open_client()
+tl::expected<int, std::string> connect_to_server(sockaddr_un& socket_address, int socket_flags)
 {
     using namespace std::string_literals;
 
-    int socket_fd = -1;
-    if (socket_fd = socket(AF_UNIX, SOCK_STREAM, 0); socket_fd == -1) {
-        return tl::unexpected("Failed to create socket"s);
-    }
-
     std::string socket_path;
     if (char* socket_env = getenv(libcardboard::ipc::SOCKET_ENV_VAR); socket_env != nullptr) {
         socket_path = socket_env;
@@ -108,24 +210,43 @@ tl::expected<Client, std::string> open_client()
             return tl::unexpected("WAYLAND_DISPLAY not set"s);
         }
     }
+    if (socket_path.size() >= sizeof(socket_address.sun_path)) {
+        return tl::unexpected("Socket path too long"s);
+    }
 
-    auto socket_address = std::make_unique<sockaddr_un>();
-    socket_address->sun_family = AF_UNIX;
-    strncpy(socket_address->sun_path, socket_path.c_str(), socket_path.size());
+    int socket_fd = -1;
+    if (socket_fd = socket(AF_UNIX, SOCK_STREAM | socket_flags, 0); socket_fd == -1) {
+        return tl::unexpected("Failed to create socket"s);
+    }
+
+    socket_address = {};
+    socket_address.sun_family = AF_UNIX;
+    strncpy(socket_address.sun_path, socket_path.c_str(), socket_path.size());
 
     if (
         connect(
             socket_fd,
-            reinterpret_cast<sockaddr*>(socket_address.get()),
+            reinterpret_cast<sockaddr*>(&socket_address),
             sizeof(sockaddr_un))
         == -1) {
         close(socket_fd);
         return tl::unexpected("Unable to connect"s);
     }
 
+    return socket_fd;
+}
+
+tl::expected<Client, std::string> open_client()
+{
+    auto socket_address = std::make_unique<sockaddr_un>();
+    auto socket_fd = connect_to_server(*socket_address);
+    if (!socket_fd) {
+        return tl::unexpected(socket_fd.error());
+    }
+
     return Client {
-        socket_fd,
+        *socket_fd,
         std::move(socket_address)
     };
 }
-}
\ No newline at end of file
+}
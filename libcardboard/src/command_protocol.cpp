@@ -16,12 +16,119 @@ You should have received a copy of the GNU General Public License along with thi
 #include <cereal/types/variant.hpp>
 #include <cereal/types/vector.hpp>
 
+#include <cstdint>
+#include <istream>
 #include <numeric>
 #include <sstream>
+#include <string>
+#include <vector>
 
 #include <cardboard/command_protocol.h>
 #include <cardboard/ipc.h>
 
+#include "memory_buffer.h"
+
+namespace {
+/**
+ * \brief Input archive for decoding requests.
+ *
+ * Requests come from any local client, so the decoder can't trust them. The archive knows how many bytes
+ * of the request are left, to reject size tags that promise more elements than the request holds,
+ * and how deeply the commands being decoded are nested in batches and bindings.
+ */
+class RequestInputArchive : public cereal::PortableBinaryInputArchive {
+public:
+    /// Maximum depth of commands nested in batches and bindings.
+    static constexpr int MAX_NESTING = 16;
+
+    RequestInputArchive(std::istream& stream, const libcardboard::MemoryBuffer& buffer)
+        : cereal::PortableBinaryInputArchive { stream }
+        , buffer { buffer }
+    {
+    }
+
+    const libcardboard::MemoryBuffer& buffer;
+    int nesting = 0;
+};
+
+/// Counts the nesting of a batch or a binding while it is loaded, and rejects requests that nest too deeply.
+class NestingGuard {
+public:
+    template <typename Archive>
+    explicit NestingGuard(Archive& ar)
+    {
+        if constexpr (Archive::is_loading::value) {
+            auto& request_archive = dynamic_cast<RequestInputArchive&>(ar);
+            if (request_archive.nesting == RequestInputArchive::MAX_NESTING) {
+                throw cereal::Exception("Commands are nested too deeply");
+            }
+            nesting = &request_archive.nesting;
+            ++*nesting;
+        }
+    }
+    NestingGuard(const NestingGuard&) = delete;
+
+    ~NestingGuard()
+    {
+        if (nesting) {
+            --*nesting;
+        }
+    }
+
+private:
+    int* nesting = nullptr;
+};
+
+/// Loads a size tag, rejecting it if the rest of the request can't hold that many elements.
+template <typename Archive>
+std::size_t load_size(Archive& ar)
+{
+    cereal::size_type size;
+    ar(cereal::make_size_tag(size));
+
+    // every element takes at least one byte
+    if (size > dynamic_cast<RequestInputArchive&>(ar).buffer.remaining()) {
+        throw cereal::Exception("Size tag exceeds the size of the request");
+    }
+    return static_cast<std::size_t>(size);
+}
+
+/// Serializes \a value. Strings and vectors are encoded like cereal does, but their size tags are checked when loading.
+template <typename Archive, typename T>
+void serialize_bounded(Archive& ar, T& value)
+{
+    ar(value);
+}
+
+template <typename Archive>
+void serialize_bounded(Archive& ar, std::string& str)
+{
+    if constexpr (Archive::is_loading::value) {
+        str.resize(load_size(ar));
+        ar(cereal::binary_data(str.data(), str.size()));
+    } else {
+        ar(str);
+    }
+}
+
+template <typename Archive, typename T>
+void serialize_bounded(Archive& ar, std::vector<T>& vector)
+{
+    if constexpr (Archive::is_loading::value) {
+        std::size_t size = load_size(ar);
+        vector.clear();
+        // grown while decoding, so the memory stays proportional to the bytes actually read
+        for (std::size_t i = 0; i < size; i++) {
+            T element;
+            serialize_bounded(ar, element);
+            vector.push_back(std::move(element));
+        }
+    } else {
+        ar(vector);
+    }
+}
+}
+
 /// \cond IGNORE
 namespace cereal {
 
@@ -40,13 +147,23 @@ void serialize(Archive& ar, command_arguments::focus& focus)
 template <typename Archive>
 void serialize(Archive& ar, command_arguments::exec& exec)
 {
-    ar(exec.argv);
+    serialize_bounded(ar, exec.argv);
+}
+
+template <typename Archive>
+void serialize(Archive& ar, command_arguments::bind::key_combo& key_combo)
+{
+    serialize_bounded(ar, key_combo.modifiers);
+    serialize_bounded(ar, key_combo.key);
 }
 
 template <typename Archive>
 void serialize(Archive& ar, command_arguments::bind& bind)
 {
-    ar(bind.modifiers, bind.key, bind.command);
+    NestingGuard nesting { ar };
+    serialize_bounded(ar, bind.mode);
+    serialize_bounded(ar, bind.sequence);
+    ar(bind.command);
 }
 
 template <typename Archive>
@@ -117,6 +234,12 @@ void serialize(Archive& ar, command_arguments::config::focus_color& focus_color)
     ar(focus_color.r, focus_color.g, focus_color.b, focus_color.a);
 }
 
+template <typename Archive>
+void serialize(Archive& ar, command_arguments::config::chord_timeout& chord_timeout)
+{
+    ar(chord_timeout.milliseconds);
+}
+
 template <typename Archive>
 void serialize(Archive& ar, command_arguments::config& config)
 {
@@ -127,21 +250,82 @@ template <typename Archive>
 void serialize(Archive&, command_arguments::cycle_width&)
 {
 }
+
+template <typename Archive>
+void serialize(Archive& ar, command_arguments::mode& mode)
+{
+    serialize_bounded(ar, mode.name);
+}
+
+template <typename Archive>
+void serialize(Archive& ar, command_arguments::subscribe& subscribe)
+{
+    ar(subscribe.events, subscribe.json);
+}
+
+template <typename Archive>
+void serialize(Archive& ar, command_arguments::get_tree& get_tree)
+{
+    ar(get_tree.since, get_tree.json);
+}
+
+template <typename Archive>
+void serialize(Archive& ar, command_arguments::get_workspaces& get_workspaces)
+{
+    ar(get_workspaces.json);
+}
+
+template <typename Archive>
+void serialize(Archive& ar, command_arguments::get_outputs& get_outputs)
+{
+    ar(get_outputs.json);
+}
+
+template <typename Archive>
+void serialize(Archive&, command_arguments::noop&)
+{
+}
+
+template <typename Archive>
+void serialize(Archive& ar, command_arguments::echo& echo)
+{
+    serialize_bounded(ar, echo.payload);
+}
+
+template <typename Archive>
+void serialize(Archive& ar, command_arguments::stats& stats)
+{
+    ar(stats.kind);
+}
+
+template <typename Archive>
+void serialize(Archive& ar, command_arguments::batch& batch)
+{
+    NestingGuard nesting { ar };
+    serialize_bounded(ar, batch.commands);
+}
+
+template <typename Archive>
+void serialize(Archive& ar, BatchResult& result)
+{
+    ar(result.success, result.message);
+}
 }
 /// \endcond
 
-tl::expected<CommandData, std::string> read_command_data(void* data, size_t size)
+tl::expected<CommandData, std::string> read_command_data(const void* data, size_t size)
 {
     try {
-        std::string buffer(static_cast<char*>(data), size);
-        std::istringstream buffer_stream { buffer };
-        cereal::PortableBinaryInputArchive archive { buffer_stream };
+        libcardboard::MemoryBuffer buffer { data, size };
+        std::istream buffer_stream { &buffer };
+        RequestInputArchive archive { buffer_stream, buffer };
 
         CommandData command_data;
         archive(command_data);
 
         return command_data;
-    } catch (const cereal::Exception& e) {
+    } catch (const std::exception& e) {
+        // besides cereal::Exception, a malformed request can still fail an allocation
         return tl::unexpected(std::string { e.what() });
     }
 }
@@ -159,3 +343,32 @@ tl::expected<std::string, std::string> write_command_data(const CommandData& com
 
     return buffer_stream.str();
 }
+
+std::string write_batch_results(const std::vector<BatchResult>& results)
+{
+    std::stringstream buffer_stream;
+
+    {
+        cereal::PortableBinaryOutputArchive archive { buffer_stream };
+        archive(results);
+    }
+
+    return buffer_stream.str();
+}
+
+tl::expected<std::vector<BatchResult>, std::string> read_batch_results(const void* data, size_t size)
+{
+    // responses come from the compositor, so the plain archive is enough here
+    try {
+        libcardboard::MemoryBuffer buffer { data, size };
+        std::istream buffer_stream { &buffer };
+        cereal::PortableBinaryInputArchive archive { buffer_stream };
+
+        std::vector<BatchResult> results;
+        archive(results);
+
+        return results;
+    } catch (const cereal::Exception& e) {
+        return tl::unexpected(std::string { e.what() });
+    }
+}
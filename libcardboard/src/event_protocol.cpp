@@ -0,0 +1,109 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+Copyright (C) 2020 Alexandru-Iulian Magan, Tudor-Ioan Roman, and contributors.
+
+This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 3.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <cardboard/event_protocol.h>
+#include <cardboard/ipc.h>
+
+#include <algorithm>
+#include <array>
+
+#include "json.h"
+
+namespace libcardboard::events {
+
+static constexpr std::array<std::string_view, TYPE_COUNT> type_names = {
+    "view_focused",
+    "workspace_focused",
+    "view_mapped",
+    "view_unmapped",
+    "output_added",
+    "output_removed",
+    "workspace_changed",
+};
+
+/// Size of the fixed part of a binary event.
+static constexpr std::size_t BINARY_HEADER_SIZE = 10;
+
+std::string_view type_name(Type type)
+{
+    return type_names[static_cast<std::size_t>(type)];
+}
+
+std::optional<Type> type_from_name(std::string_view name)
+{
+    if (auto it = std::find(type_names.begin(), type_names.end(), name); it != type_names.end()) {
+        return static_cast<Type>(it - type_names.begin());
+    }
+
+    return std::nullopt;
+}
+
+std::string encode_binary(const Event& event)
+{
+    std::size_t output_size = std::min<std::size_t>(event.output.size(), UINT8_MAX);
+    std::string buffer(BINARY_HEADER_SIZE + output_size, '\0');
+    auto* data = reinterpret_cast<std::byte*>(buffer.data());
+
+    data[0] = static_cast<std::byte>(event.type);
+    ipc::write_u32(data + 1, static_cast<uint32_t>(event.workspace));
+    ipc::write_u32(data + 5, event.view);
+    data[9] = static_cast<std::byte>(output_size);
+    buffer.replace(BINARY_HEADER_SIZE, output_size, event.output, 0, output_size);
+
+    return buffer;
+}
+
+std::string encode_json(const Event& event)
+{
+    std::string json = "{";
+    json::append_key(json, "event");
+    json::append_string(json, type_name(event.type));
+    json += ',';
+    json::append_key(json, "workspace");
+    json += std::to_string(event.workspace);
+    json += ',';
+    json::append_key(json, "view");
+    json += std::to_string(event.view);
+    json += ',';
+    json::append_key(json, "output");
+    json::append_string(json, event.output);
+    json += '}';
+
+    return json;
+}
+
+tl::expected<Event, std::string> decode_binary(const void* data, std::size_t size)
+{
+    using namespace std::string_literals;
+
+    const auto* bytes = static_cast<const std::byte*>(data);
+    if (size < BINARY_HEADER_SIZE) {
+        return tl::unexpected("truncated event"s);
+    }
+
+    auto type = static_cast<std::size_t>(bytes[0]);
+    if (type >= TYPE_COUNT) {
+        return tl::unexpected("unknown event type "s + std::to_string(type));
+    }
+
+    auto output_size = static_cast<std::size_t>(bytes[9]);
+    if (size != BINARY_HEADER_SIZE + output_size) {
+        return tl::unexpected("malformed event"s);
+    }
+
+    return Event {
+        static_cast<Type>(type),
+        static_cast<int32_t>(ipc::read_u32(bytes + 1)),
+        ipc::read_u32(bytes + 5),
+        std::string(reinterpret_cast<const char*>(bytes + BINARY_HEADER_SIZE), output_size),
+    };
+}
+
+}
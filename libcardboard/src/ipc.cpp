@@ -10,37 +10,42 @@ You should have received a copy of the GNU General Public License along with thi
 */
 #include <cardboard/ipc.h>
 
-#include <bit>
-
 namespace libcardboard::ipc {
 
+// all the integers are sent in little endian
+
+uint32_t read_u32(const std::byte* data)
+{
+    return static_cast<uint32_t>(data[0])
+        | static_cast<uint32_t>(data[1]) << 8u
+        | static_cast<uint32_t>(data[2]) << 16u
+        | static_cast<uint32_t>(data[3]) << 24u;
+}
+
+void write_u32(std::byte* data, uint32_t value)
+{
+    data[0] = static_cast<std::byte>(value & 0xffu);
+    data[1] = static_cast<std::byte>((value >> 8u) & 0xffu);
+    data[2] = static_cast<std::byte>((value >> 16u) & 0xffu);
+    data[3] = static_cast<std::byte>((value >> 24u) & 0xffu);
+}
+
 Header interpret_header(const AlignedHeaderBuffer& buffer)
 {
-    if constexpr (std::endian::native == std::endian::little) {
-        return { *reinterpret_cast<const int32_t*>(buffer.data()) };
-    } else {
-        uint32_t r = *reinterpret_cast<const uint32_t*>(buffer.data());
-        r = (r & 0x000000ffu) << 24u | (r & 0x0000ff00u) << 8u | (r & 0x00ff0000u) >> 8u | (r & 0xff000000u) >> 24u;
-
-        return { static_cast<int>(r) };
-    }
+    return {
+        static_cast<int>(read_u32(buffer.data())),
+        read_u32(buffer.data() + 4),
+    };
 }
 
 AlignedHeaderBuffer create_header_buffer(const Header& header)
 {
     AlignedHeaderBuffer buffer;
 
-    *reinterpret_cast<int*>(buffer.data()) = header.incoming_bytes;
-
-    if constexpr (std::endian::native == std::endian::big) {
-        uint32_t r = *reinterpret_cast<int*>(buffer.data());
-
-        r = ((r >> 24u) & 0x000000ffu) | ((r << 8u) & 0x00ff0000u) | ((r >> 8u) & 0x0000ff00u) | ((r << 24u) & 0xff000000u);
-
-        *reinterpret_cast<int*>(buffer.data()) = r;
-    }
+    write_u32(buffer.data(), static_cast<uint32_t>(header.incoming_bytes));
+    write_u32(buffer.data() + 4, header.request_id);
 
     return buffer;
 }
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,50 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+Copyright (C) 2020 Alexandru-Iulian Magan, Tudor-Ioan Roman, and contributors.
+
+This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 3.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef LIBCARDBOARD_JSON_H_INCLUDED
+#define LIBCARDBOARD_JSON_H_INCLUDED
+
+#include <string>
+#include <string_view>
+
+/// Minimal helpers for the JSON encoders of libcardboard. Not installed.
+namespace libcardboard::json {
+
+/// Appends \a value to \a json as a quoted and escaped JSON string.
+inline void append_string(std::string& json, std::string_view value)
+{
+    static constexpr char hex[] = "0123456789abcdef";
+
+    json += '"';
+    for (char c : value) {
+        if (c == '"' || c == '\\') {
+            json += '\\';
+            json += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            json += "\\u00";
+            json += hex[(c >> 4) & 0xf];
+            json += hex[c & 0xf];
+        } else {
+            json += c;
+        }
+    }
+    json += '"';
+}
+
+/// Appends <tt>"key":</tt> to \a json.
+inline void append_key(std::string& json, std::string_view key)
+{
+    append_string(json, key);
+    json += ':';
+}
+
+}
+
+#endif // LIBCARDBOARD_JSON_H_INCLUDED
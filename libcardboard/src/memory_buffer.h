@@ -0,0 +1,35 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+Copyright (C) 2020 Alexandru-Iulian Magan, Tudor-Ioan Roman, and contributors.
+
+This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 3.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef LIBCARDBOARD_MEMORY_BUFFER_H_INCLUDED
+#define LIBCARDBOARD_MEMORY_BUFFER_H_INCLUDED
+
+#include <cstddef>
+#include <streambuf>
+
+namespace libcardboard {
+
+/// Read-only stream buffer over a region of memory that it doesn't own. Lets cereal decode without copying.
+class MemoryBuffer : public std::streambuf {
+public:
+    MemoryBuffer(const void* data, std::size_t size)
+    {
+        // the get area is never written to, std::streambuf just doesn't have a const interface
+        auto* begin = const_cast<char*>(static_cast<const char*>(data));
+        setg(begin, begin, begin + size);
+    }
+
+    /// Returns the number of bytes that weren't read yet.
+    std::size_t remaining() const { return static_cast<std::size_t>(egptr() - gptr()); }
+};
+
+}
+
+#endif // LIBCARDBOARD_MEMORY_BUFFER_H_INCLUDED
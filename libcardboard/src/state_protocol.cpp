@@ -0,0 +1,215 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+Copyright (C) 2020 Alexandru-Iulian Magan, Tudor-Ioan Roman, and contributors.
+
+This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 3.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <cereal/archives/portable_binary.hpp>
+#include <cereal/types/string.hpp>
+#include <cereal/types/vector.hpp>
+
+#include <istream>
+#include <sstream>
+
+#include <cardboard/state_protocol.h>
+
+#include "json.h"
+#include "memory_buffer.h"
+
+/// \cond IGNORE
+namespace cereal {
+
+template <typename Archive>
+void serialize(Archive& ar, libcardboard::state::Box& box)
+{
+    ar(box.x, box.y, box.width, box.height);
+}
+
+template <typename Archive>
+void serialize(Archive& ar, libcardboard::state::View& view)
+{
+    ar(view.id, view.box, view.fullscreen);
+}
+
+template <typename Archive>
+void serialize(Archive& ar, libcardboard::state::Column& column)
+{
+    ar(column.tiles);
+}
+
+template <typename Archive>
+void serialize(Archive& ar, libcardboard::state::Workspace& workspace)
+{
+    ar(workspace.index, workspace.output, workspace.scroll_x, workspace.columns, workspace.floating_views);
+}
+
+template <typename Archive>
+void serialize(Archive& ar, libcardboard::state::Output& output)
+{
+    ar(output.name, output.box, output.usable_area, output.scale);
+}
+
+template <typename Archive>
+void serialize(Archive& ar, libcardboard::state::Tree& tree)
+{
+    ar(tree.generation, tree.since, tree.focused_workspace, tree.focused_view, tree.outputs_changed, tree.outputs, tree.workspaces);
+}
+}
+/// \endcond
+
+namespace libcardboard::state {
+
+template <typename T>
+static std::string write(const T& value)
+{
+    std::stringstream buffer_stream;
+
+    {
+        cereal::PortableBinaryOutputArchive archive { buffer_stream };
+        archive(value);
+    }
+
+    return buffer_stream.str();
+}
+
+template <typename T>
+static tl::expected<T, std::string> read(const void* data, std::size_t size)
+{
+    try {
+        MemoryBuffer buffer { data, size };
+        std::istream buffer_stream { &buffer };
+        cereal::PortableBinaryInputArchive archive { buffer_stream };
+
+        T value;
+        archive(value);
+
+        return value;
+    } catch (const cereal::Exception& e) {
+        return tl::unexpected(std::string { e.what() });
+    }
+}
+
+static void append_json(std::string& json, const Box& box)
+{
+    json += "{\"x\":" + std::to_string(box.x)
+        + ",\"y\":" + std::to_string(box.y)
+        + ",\"width\":" + std::to_string(box.width)
+        + ",\"height\":" + std::to_string(box.height) + '}';
+}
+
+static void append_json(std::string& json, const View& view)
+{
+    json += "{\"id\":" + std::to_string(view.id) + ",\"box\":";
+    append_json(json, view.box);
+    json += ",\"fullscreen\":";
+    json += view.fullscreen ? "true" : "false";
+    json += '}';
+}
+
+template <typename T>
+static void append_json(std::string& json, const std::vector<T>& values)
+{
+    json += '[';
+    for (const auto& value : values) {
+        if (&value != &values.front()) {
+            json += ',';
+        }
+        append_json(json, value);
+    }
+    json += ']';
+}
+
+static void append_json(std::string& json, const Column& column)
+{
+    append_json(json, column.tiles);
+}
+
+static void append_json(std::string& json, const Workspace& workspace)
+{
+    json += "{\"index\":" + std::to_string(workspace.index) + ",\"output\":";
+    json::append_string(json, workspace.output);
+    json += ",\"scroll_x\":" + std::to_string(workspace.scroll_x) + ",\"columns\":";
+    append_json(json, workspace.columns);
+    json += ",\"floating_views\":";
+    append_json(json, workspace.floating_views);
+    json += '}';
+}
+
+static void append_json(std::string& json, const Output& output)
+{
+    json += "{\"name\":";
+    json::append_string(json, output.name);
+    json += ",\"box\":";
+    append_json(json, output.box);
+    json += ",\"usable_area\":";
+    append_json(json, output.usable_area);
+    json += ",\"scale\":" + std::to_string(output.scale) + '}';
+}
+
+std::string write_tree(const Tree& tree)
+{
+    return write(tree);
+}
+
+tl::expected<Tree, std::string> read_tree(const void* data, std::size_t size)
+{
+    return read<Tree>(data, size);
+}
+
+std::string tree_to_json(const Tree& tree)
+{
+    std::string json = "{\"generation\":" + std::to_string(tree.generation)
+        + ",\"since\":" + std::to_string(tree.since)
+        + ",\"focused_workspace\":" + std::to_string(tree.focused_workspace)
+        + ",\"focused_view\":" + std::to_string(tree.focused_view)
+        + ",\"outputs_changed\":" + (tree.outputs_changed ? "true" : "false")
+        + ",\"outputs\":";
+    append_json(json, tree.outputs);
+    json += ",\"workspaces\":";
+    append_json(json, tree.workspaces);
+    json += '}';
+
+    return json;
+}
+
+std::string write_workspaces(const std::vector<Workspace>& workspaces)
+{
+    return write(workspaces);
+}
+
+tl::expected<std::vector<Workspace>, std::string> read_workspaces(const void* data, std::size_t size)
+{
+    return read<std::vector<Workspace>>(data, size);
+}
+
+std::string workspaces_to_json(const std::vector<Workspace>& workspaces)
+{
+    std::string json;
+    append_json(json, workspaces);
+
+    return json;
+}
+
+std::string write_outputs(const std::vector<Output>& outputs)
+{
+    return write(outputs);
+}
+
+tl::expected<std::vector<Output>, std::string> read_outputs(const void* data, std::size_t size)
+{
+    return read<std::vector<Output>>(data, size);
+}
+
+std::string outputs_to_json(const std::vector<Output>& outputs)
+{
+    std::string json;
+    append_json(json, outputs);
+
+    return json;
+}
+
+}